@@ -1,13 +1,17 @@
 #include "raylib.h"
 #include "physics_engine.hpp"
+#include "physics_world.hpp"
 #include "physics_ui.hpp"
 #include "physics_functions.hpp"
 #include "physics_editor.hpp"
 #include "physics_localisation.hpp"
+#include "physics_scene.hpp"
+#include "physics_headless.hpp"
+#include "physics_recorder.hpp"
+#include "physics_sim.hpp"
 
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <cstring>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
@@ -28,8 +32,8 @@ extern bool editingTrailLifetime;
 extern double trailLifetime;
 extern double mouseWheelScaleFactor;
 
-extern std::list<Object*> objectList;
-auto lastVisitedObject = objectList.begin();
+extern BodyStore bodies;
+size_t lastVisitedObject = 0;
 extern std::list<UI*> UIList;
 
 // ---------------- Web helpers (WASM) ----------------
@@ -105,122 +109,17 @@ static void Web_DownloadFile(const char*) {}
 
 #endif // __EMSCRIPTEN__
 
-// ---------------- CSV scene save/load ----------------
-void ClearScene() {
-    for (auto* o : objectList) delete o;
-    objectList.clear();
-}
-
-void SaveSceneCSV(const char* path) {
-    std::ofstream ofs(path);
-    if (!ofs) return;
-
-    // Header:
-    ofs << "Width,Height,Pos_X,Pos_Y,Speed_X,Speed_Y,Mass,Friction,Elasticity,"
-           "GravityAffected,LeaveTrail,Fixed,Color_R,Color_G,Color_B\n";
-
-    for (auto* o : objectList) {
-        if (dynamic_cast<TrailParticle*>(o)) {continue;}
-        if (dynamic_cast<Particle*>(o)) {continue;}
-        double width = 0.0;
-        double height = 0.0;
-
-        if (auto* c = dynamic_cast<CircularObject*>(o)) {
-            width  = 0.0;                 // circle flag
-            height = c->radius * 2.0;     // radius = Height/2
-        } else if (auto* r = dynamic_cast<RectangularObject*>(o)) {
-            width  = r->sides.x;
-            height = r->sides.y;
-        } else {
-            continue; // unknown type – skip
-        }
-
-        ofs << width << ','
-            << height << ','
-            << o->pos.x << ','
-            << o->pos.y << ','
-            << o->speed.x << ','
-            << o->speed.y << ','
-            << o->mass << ','
-            << o->frictionFactor << ','
-            << o->elasticity << ','
-            << (o->gravityAffected ? 1 : 0) << ','
-            << (o->leaveTrail ? 1 : 0) << ','
-            << (o->fixed ? 1 : 0) << ','
-            << (int)o->color.r << ','
-            << (int)o->color.g << ','
-            << (int)o->color.b << '\n';
-    }
-}
-
-void LoadSceneCSV(const char* path) {
-    std::ifstream ifs(path);
-    if (!ifs) return;
-
-    ClearScene();
-
-    std::string line;
-    if (!std::getline(ifs, line)) return; // skip header
-
-    while (std::getline(ifs, line)) {
-        if (line.empty()) continue;
-        std::stringstream ss(line);
-        std::string cell;
-
-        auto readDouble = [&]() -> double {
-            if (!std::getline(ss, cell, ',')) return 0.0;
-            if (cell.empty()) return 0.0;
-            return std::stod(cell);
-        };
-        auto readInt = [&]() -> int {
-            if (!std::getline(ss, cell, ',')) return 0;
-            if (cell.empty()) return 0;
-            return std::stoi(cell);
-        };
-
-        double width   = readDouble();
-        double height  = readDouble();
-        double posx    = readDouble();
-        double posy    = readDouble();
-        double speedx  = readDouble();
-        double speedy  = readDouble();
-        double mass    = readDouble();
-        double friction= readDouble();
-        double elast   = readDouble();
-        int grav       = readInt();
-        int trail      = readInt();
-        int fixedFlag  = readInt();
-        int cr         = readInt();
-        int cg         = readInt();
-        int cb         = readInt();
-
-        Color color = {(unsigned char)cr, (unsigned char)cg, (unsigned char)cb, 255};
-        Vector2 pos = vector(posx, posy);
-        Vector2 vel = vector(speedx, speedy);
-
-        Object* o = nullptr;
-
-        if (width == 0.0) {
-            double radius = height * 0.5;
-            o = new PhysicsCircularObject(pos, vel, color, mass, radius, friction, trail != 0);
-        } else {
-            Vector2 sides = vector(width, height);
-            o = new PhysicsRectangularObject(pos, vel, color, mass, sides, friction);
-            o->leaveTrail = (trail != 0);
-        }
-
-        o->elasticity      = (float)elast;
-        o->gravityAffected = (grav != 0);
-        o->fixed           = (fixedFlag != 0);
-
-        objectList.push_back(o);
-    }
-
-    lastVisitedObject = objectList.begin();
-}
-
 void OnFileLoaded(const char* path) {
-    LoadSceneCSV(path);
+    std::string file = path;
+    sim.post([file]{
+        const char* path = file.c_str();
+        SceneLoadReport report = LoadScene(path);
+        for (const auto& e : report.errors)
+            TraceLog(LOG_WARNING, "%s:%zu: %s", path, e.line, e.message.c_str());
+        if (report.errorCount > 0)
+            TraceLog(LOG_WARNING, "%s: %zu rows loaded, %zu skipped", path, report.rows, report.errorCount);
+    });
+    lastVisitedObject = 0;
 }
 
 // ---------------- UI & main ----------------
@@ -232,13 +131,30 @@ void UIPreInit(){
   UIList.push_back(new WindowScaleUI());
   UIList.push_back(new TimeScaleUI(0,24));
   UIList.push_back(new PauseUI(6,-32));
-  UIList.push_back(new OwnershipUI(L("creator.myname"),-260,0));
+  UIList.push_back(new OwnershipUI(std::string(L(Str::CreatorMyName)),-260,0));
   UIList.push_back(new VisualScaleUI(0,48));
   UIList.push_back(new TrailLifetimeUI(0,48));
+  UIList.push_back(new GravitySolverUI(0,72));
+  UIList.push_back(new BroadphaseUI(0,90));
+  UIList.push_back(new IntegratorUI(0,108));
+  UIList.push_back(new RecorderUI(0,126));
+  UIList.push_back(new SaveStatusUI(0,144));
+  UIList.push_back(new CullingUI(0,162));
+  UIList.push_back(new SimRateUI(0,180));
+  UIList.push_back(new ProfilerUI(-340,24));
 }
 
 int main(int argc, char** argv){
-  lang = (argc > 1) ? argv[1] : lang;
+  if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) return RunHeadless(argc - 2, argv + 2);
+  if (argc > 2 && std::strcmp(argv[1], "--replay") == 0){
+    if (!replay.open(argv[2])){
+      std::fprintf(stderr, "replay: cannot read %s\n", argv[2]);
+      return 1;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc > 1) SetLanguage(argv[1]);
   
   //debugPreInit();
   UIPreInit();
@@ -251,8 +167,11 @@ int main(int argc, char** argv){
   SetTargetFPS(60);
   
   PhysEditor::Init();
+  Profiler::setThreadName("render");
+  sim.start();
   
   while(!WindowShouldClose()){
+    const SimView& view = sim.acquire();
     if(IsWindowResized()){
       screenWidth = GetScreenWidth();
       screenHeight = GetScreenHeight();
@@ -267,7 +186,10 @@ int main(int argc, char** argv){
       else PhysEditor::TryPickOrbitTarget(GetMousePosition());
     }
     if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)){
-      PhysEditor::OnRightClick(GetMousePosition());
+      PhysEditor::OnRightPress(GetMousePosition());
+    }
+    if (IsMouseButtonReleased(MOUSE_BUTTON_RIGHT)){
+      PhysEditor::OnRightRelease(GetMousePosition());
     }
     if(IsKeyPressed(KEY_SPACE)){
       windowPos=vector();
@@ -295,25 +217,25 @@ int main(int argc, char** argv){
     }
 #endif
 
-    // I = save scene to CSV
-    if(IsKeyPressed(KEY_I)){
-      const char* path = "scene.csv";
-      SaveSceneCSV(path);
+    // I = save scene to CSV (captured now, written in the background)
+    if(IsKeyPressed(KEY_I)) sceneSaver.start("scene.csv", view.scene);
+    if(sceneSaver.poll()){
 #ifdef __EMSCRIPTEN__
-      Web_DownloadFile(path);
+      Web_DownloadFile(sceneSaver.path().c_str());
 #endif
     }
 
     if(IsKeyPressed(KEY_PERIOD)){
       int visited_obj = 0;
-      if(objectList.size()>0){
-        if(lastVisitedObject==objectList.end()) lastVisitedObject=objectList.begin();
-        windowPos=(*lastVisitedObject)->pos-vector(screenWidth,screenHeight)*windowScale/2;
+      const auto& rows = view.scene.rows;
+      if(rows.size()>0){
+        if(lastVisitedObject>=rows.size()) lastVisitedObject=0;
+        windowPos=rows[lastVisitedObject].pos-vector(screenWidth,screenHeight)*windowScale/2;
         do{
           lastVisitedObject++;
           visited_obj++;
-          if(lastVisitedObject==objectList.end()) lastVisitedObject=objectList.begin();
-        }while((*lastVisitedObject)->mass==0 && visited_obj<objectList.size());
+          if(lastVisitedObject>=rows.size()) lastVisitedObject=0;
+        }while(rows[lastVisitedObject].mass==0 && visited_obj<(int)rows.size());
       }
     }
     if(IsKeyDown(KEY_W)){
@@ -330,55 +252,100 @@ int main(int argc, char** argv){
     }
     if(IsKeyPressed(KEY_EQUAL)){
       if(visualScaling) windowVisualScale+=0.1*keyscale;
-      else if(editingTrailLifetime) trailLifetime+=keyscale;
+      else if(editingTrailLifetime) sim.post([keyscale]{ trailLifetime+=keyscale; });
       else timeScale+=0.1*keyscale;
     }
     if(IsKeyPressed(KEY_MINUS)){
       if(visualScaling) windowVisualScale-=0.1*keyscale;
-      else if(editingTrailLifetime) trailLifetime-=keyscale;
+      else if(editingTrailLifetime) sim.post([keyscale]{ trailLifetime-=keyscale; });
       else timeScale-=0.1*keyscale;
     }
     if(IsKeyPressed(KEY_C)){
       visualScaling=!visualScaling;
       if(visualScaling)editingTrailLifetime=false;
     }
+    if(IsKeyPressed(KEY_G)){
+      sim.post([]{ gravitySolver=(GravitySolver)(((int)gravitySolver+1)%(int)GravitySolver::Count); });
+    }
+    if(IsKeyPressed(KEY_V)){
+      sim.post([]{ integrator=(Integrator)(((int)integrator+1)%(int)Integrator::Count); });
+    }
+    // P = profiler overlay, K = start/stop a Chrome trace capture (written to profile.json)
+    if(IsKeyPressed(KEY_P)){
+      showProfiler=!showProfiler;
+    }
+    if(IsKeyPressed(KEY_K)){
+      if(!Profiler::capturing.load()) Profiler::beginCapture();
+      else {
+        long events = Profiler::endCapture("profile.json");
+        if(events < 0) TraceLog(LOG_WARNING, "profiler: cannot write profile.json");
+        else TraceLog(LOG_INFO, "profiler: %ld events written to profile.json", events);
+      }
+    }
     if(IsKeyPressed(KEY_T)){
       editingTrailLifetime=!editingTrailLifetime;
       if(editingTrailLifetime)visualScaling=false;
     }
+    // R = start/stop recording the trajectory; in replay arrows seek (scaled like the other keys), Home rewinds
+    if(IsKeyPressed(KEY_R) && !replay.active()){
+      sim.post([]{
+        if(recorder.recording()) recorder.stop();
+        else recorder.start("recording.trj");
+      });
+    }
+    if(replay.active()){
+      if(IsKeyPressed(KEY_RIGHT)) replay.advance((int64_t)std::max(1.0,keyscale));
+      if(IsKeyPressed(KEY_LEFT)) replay.advance(-(int64_t)std::max(1.0,keyscale));
+      if(IsKeyPressed(KEY_HOME)) replay.seek(0);
+    }
     auto mw_mv = -GetMouseWheelMove()*mouseWheelScaleFactor*keyscale;
     
     windowScale+=mw_mv;
     if(windowScale<0.1)windowScale=0.1;
     else if(mw_mv>0)windowPos-=vector(screenWidth,screenHeight)*mw_mv/2;
     else if(mw_mv<0)windowPos-=vector(screenWidth,screenHeight)*mw_mv/2;
+    // the simulation thread picks these up on its next tick; web builds tick here instead
+    sim.setClock(paused || replay.active(), timeScale);
+#ifdef __EMSCRIPTEN__
+    sim.tick(GetFrameTime());
+#endif
     BeginDrawing();
     
     ClearBackground(BLACK);
-    for(const auto& s : gStars){
-      DrawCircleV(s.pos,s.size,s.color);
+    {
+      Profiler::Scope zone(Profiler::Phase::Draw);
+      shapeBatch.begin();
+      DrawStars();
+      if (replay.active()) {
+          // recorded frames only, no physics
+          if (!paused && replay.frame() + 1 < replay.frames()) replay.advance();
+          replay.draw();
+      } else {
+        DrawView(view);
+      }
     }
-    auto it = objectList.begin();
-    while (it != objectList.end()) {
-        if ((*it)->shouldRemove) {
-            delete *it;
-            it = objectList.erase(it);
-        } else {
-            if (!paused) {
-                (*it)->tick();
-            }
-            (*it)->draw();
-            ++it;
-        }
+    Profiler::history.sample();
+    {
+      Profiler::Scope zone(Profiler::Phase::UI);
+      // HUD text is queued and drawn in one pass per layer, so the editor panel still covers the HUD
+      for(auto it=UIList.begin();it!=UIList.end();it++){
+        (*it)->draw();
+      }
+      textBatch.flush(uiFont);
+      PhysEditor::Draw();
+      textBatch.flush(uiFont);
     }
-    for(auto it=UIList.begin();it!=UIList.end();it++){
-      (*it)->draw();
+    {
+      // rlgl flushes its batch here, then waits for vsync
+      Profiler::Scope zone(Profiler::Phase::Present);
+      EndDrawing();
     }
-    PhysEditor::Draw();
-    EndDrawing();
   }
   CloseWindow();
-  for (auto obj : objectList) delete obj;
+  sim.stop();
+  recorder.stop();
+  sceneSaver.wait();
+  bodies.clear();
   for (auto UI : UIList) delete UI;
   UnloadFont(uiFont);
 }
@@ -0,0 +1,115 @@
+#pragma once
+#include "raylib.h"
+#include "rlgl.h"
+#include <cmath>
+#include <algorithm>
+
+// ---------------- batched shape rendering ----------------
+// Streams screen-space circles and rectangles straight into rlgl's vertex buffer as plain triangles,
+// so a frame of bodies, particles and stars becomes a handful of draw calls instead of one
+// DrawCircleV/DrawRectangleRec (36 segments each) per object. Circles pick their segment count from
+// the on-screen radius and collapse to a one-pixel quad below half a pixel, so the vertex count follows
+// what is visible rather than how many objects there are. Winding matches raylib's shapes module,
+// which keeps back-face culling happy. Callers cull against the screen with visibleCircle/visibleRect
+// before fetching anything else about an object, so off-screen objects cost a few flops each.
+class ShapeBatch {
+  public:
+  static constexpr int minSegments = 6;
+  static constexpr int maxSegments = 72;
+  static constexpr float pointRadius = 0.5f;   // pixels; smaller circles are drawn as points
+  static constexpr float maxErrorPx = 0.5f;    // chord deviation allowed when picking segments
+  static constexpr int chunkVertices = 3 * 1024; // fits rlgl's smallest (GLES2) default batch
+
+  // per-frame counters, reset by begin()
+  size_t circles = 0, points = 0, rects = 0, vertices = 0;
+  size_t culled = 0;
+
+  void begin(){
+    circles = points = rects = vertices = culled = 0;
+    viewW = (float)GetScreenWidth();
+    viewH = (float)GetScreenHeight();
+  }
+
+  size_t drawn() const { return circles + points + rects; }
+
+  // screen-space visibility tests; false counts the object as culled
+  bool visibleCircle(Vector2 c, float r){
+    r = std::max(r, pointRadius);
+    return visible(c.x - r, c.y - r, c.x + r, c.y + r);
+  }
+  bool visibleRect(Rectangle r){
+    return visible(r.x, r.y, r.x + r.width, r.y + r.height);
+  }
+
+  static int segmentsFor(float r){
+    if (r <= maxErrorPx) return minSegments;
+    int n = (int)std::ceil(PI / std::acos(1.0f - maxErrorPx / r));
+    return std::clamp(n, minSegments, maxSegments);
+  }
+
+  void circle(Vector2 c, float r, Color col){
+    if (r < pointRadius){
+      ++points;
+      quad(c.x - 0.5f, c.y - 0.5f, c.x + 0.5f, c.y + 0.5f, col);
+      return;
+    }
+    ++circles;
+    const int n = segmentsFor(r);
+    reserve(3 * n, col);
+    const float step = 2 * PI / n;
+    const float cs = std::cos(step), sn = std::sin(step);
+    float x = r, y = 0; // current rim point relative to c, rotated by step each segment
+    for (int i = 0; i < n; ++i){
+      float nx = x * cs - y * sn, ny = x * sn + y * cs;
+      rlVertex2f(c.x, c.y);
+      rlVertex2f(c.x + nx, c.y + ny);
+      rlVertex2f(c.x + x, c.y + y);
+      x = nx; y = ny;
+    }
+  }
+
+  void rect(Rectangle r, Color col){
+    ++rects;
+    quad(r.x, r.y, r.x + r.width, r.y + r.height, col);
+  }
+
+  // closes the open rlBegin block; rlgl draws it with the rest of its batch
+  void end(){
+    if (open) rlEnd();
+    open = false;
+    used = 0;
+  }
+
+  private:
+  bool open = false;
+  int used = 0; // vertices in the open block
+  float viewW = 0, viewH = 0;
+
+  bool visible(float x0, float y0, float x1, float y1){
+    if (x1 < 0 || y1 < 0 || x0 > viewW || y0 > viewH){
+      ++culled;
+      return false;
+    }
+    return true;
+  }
+
+  void reserve(int n, Color col){
+    if (open && used + n > chunkVertices) end();
+    if (!open){
+      rlCheckRenderBatchLimit(chunkVertices);
+      rlBegin(RL_TRIANGLES);
+      open = true;
+    }
+    used += n;
+    vertices += n;
+    rlColor4ub(col.r, col.g, col.b, col.a);
+  }
+
+  void quad(float x0, float y0, float x1, float y1, Color col){
+    reserve(6, col);
+    rlVertex2f(x0, y0); rlVertex2f(x0, y1); rlVertex2f(x1, y0);
+    rlVertex2f(x1, y0); rlVertex2f(x0, y1); rlVertex2f(x1, y1);
+  }
+};
+
+ShapeBatch shapeBatch;
@@ -0,0 +1,353 @@
+#include "raylib.h"
+#include "physics_engine.hpp"
+#include "physics_world.hpp"
+#include "physics_snapshot.hpp"
+#include "physics_sim.hpp"
+#include "physics_generators.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+// Engine benchmarks on seeded, reproducible scenes. One JSON object per line on stdout, e.g.
+//   {"scene":"plummer","case":"forces","bodies":10000,"steps":20,"ns_per_body_step":812.4,...}
+// "bodies" is what the time is divided by: simulated bodies for the world phases, spawned particles
+// for "explosion", rows for the CSV and binary (bin = raw, binz = compressed) cases and drawn objects
+// for "publish" (the per-frame copy handed to the render thread), "draw" and "draw_zoomed" (the camera
+// 100x closer, so most of it is culled). "csv_capture" is the copy an async save (key I) makes before
+// writing in the background. "kernel" times one exact (direct sum) computeForces() per gravity kernel the
+// CPU supports, whatever the solver option, and checks it against the scalar double path: max_rel_error
+// is the largest force difference over the rms force, and the exit status is 1 if any kernel is past its
+// tolerance or if explosion debris repeats between two body ticks of one substep. "accuracy" is error versus time for the approximate solvers: Barnes-Hut at --theta, then the
+// FMM at orders 2, 4, ... 12 and --fmm-theta, each against direct summation on a sample of ~1000 bodies.
+// Build next to physics.cpp:
+//   g++ -O2 -std=c++17 physics_bench.cpp -o physics_bench -lraylib -pthread
+//   ./physics_bench [--n 10000] [--steps 20] [--seed 1] [--threads T] [--integrator name] [--scene name]
+//                   [--solver exact|barnes-hut|fmm] [--order p] [--fmm-theta θ]
+//                   [--kernel scalar|sse2|avx2|avx512] [--precision double|float] [--no-draw]
+
+// ---------------- allocation counting ----------------
+static std::atomic<unsigned long long> gAllocations{0};
+
+void* operator new(std::size_t n){
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// ---------------- options & output ----------------
+struct BenchOptions {
+  size_t n = 10000;
+  int steps = 20;
+  unsigned seed = 1;
+  std::string scene;   // empty => all scenes
+  bool draw = true;
+};
+
+struct BenchResult {
+  const char* scene;
+  const char* name;
+  size_t bodies;
+  int steps;
+  double seconds;
+  unsigned long long allocations;
+  double error = -1; // kernel cases only
+};
+
+static int gCheckFailures = 0; // kernels past their tolerance, repeated debris
+
+static void PrintResult(const BenchOptions& opt, const BenchResult& r){
+  double perUnit = r.bodies > 0 && r.steps > 0 ? r.seconds * 1e9 / ((double)r.bodies * r.steps) : 0.0;
+  double allocsPerStep = r.steps > 0 ? (double)r.allocations / r.steps : 0.0;
+  std::printf("{\"scene\":\"%s\",\"case\":\"%s\",\"bodies\":%zu,\"steps\":%d,\"total_ms\":%.3f,"
+              "\"ns_per_body_step\":%.2f,\"allocs_per_step\":%.2f,\"seed\":%u,\"threads\":%u,\"theta\":%.3f,\"solver\":\"%s\",\"integrator\":\"%s\","
+              "\"kernel\":\"%s\",\"precision\":\"%s\"",
+              r.scene, r.name, r.bodies, r.steps, r.seconds * 1e3, perUnit, allocsPerStep,
+              opt.seed, threadPool.size(), barnesHutTheta, gravitySolverNames[(int)gravitySolver], integratorNames[(int)integrator],
+              Simd::isaNames[(int)std::min(gravityIsa, Simd::supported)], Simd::precisionNames[(int)gravityPrecision]);
+  if (gravitySolver == GravitySolver::Fmm) std::printf(",\"order\":%d,\"fmm_theta\":%.3f", fmmOrder, fmmTheta);
+  if (r.error >= 0) std::printf(",\"max_rel_error\":%.3g", r.error);
+  std::printf("}\n");
+  std::fflush(stdout);
+}
+
+template<class F>
+static BenchResult Measure(const char* scene, const char* name, size_t bodyCount, int steps, F&& f){
+  unsigned long long allocs = gAllocations.load();
+  auto start = std::chrono::steady_clock::now();
+  for (int s = 0; s < steps; ++s) f();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return {scene, name, bodyCount, steps, seconds, gAllocations.load() - allocs};
+}
+
+static size_t SimulatedCount(){
+  size_t n = 0;
+  for (size_t j = 0; j < bodies.size(); ++j) n += bodies.flags[j].simulated && !bodies.flags[j].shouldRemove;
+  return n;
+}
+
+// ---------------- scenes ----------------
+struct BenchScene {
+  const char* name;
+  void (*generate)(size_t n);
+};
+
+static const BenchScene kScenes[] = {
+  {"disc",      [](size_t n){ SceneGen::UniformDisc(n, 1e4, 1e20); }},
+  {"plummer",   [](size_t n){ SceneGen::PlummerSphere(n, 2e3, 1e20); }},
+  {"rectstack", [](size_t n){ SceneGen::RectangleStacks(n); }},
+  {"fireworks", [](size_t n){ SceneGen::FireworkStorm(n); }},
+  {"kepler",    [](size_t n){
+    bodies.spawn<PhysicsCircularObject>(vector(0, 0), vector(0, 0), WHITE, 1e20, 50, 0);
+    SceneGen::KeplerDisc(n, 1e3, 1e4, 1e20, {0, 0}, {0, 0}, [](Vector2 p, Vector2 v){
+      bodies.spawn<PhysicsCircularObject>(p, v, randomColor(), 1e3, 2, 0);
+    });
+  }},
+};
+
+static void RunScene(const BenchOptions& opt, const BenchScene& scene){
+  ClearScene();
+  world = World();
+  world.seed(opt.seed);
+  scene.generate(opt.n);
+  bodies.removeMarked();
+  const double dt = world.fixedDt;
+  size_t simulated = SimulatedCount();
+
+  // warm-up so first-touch allocations of the phase buffers don't count
+  world.substep(dt);
+
+  PrintResult(opt, Measure(scene.name, "forces", simulated, opt.steps, []{ world.computeForces(); }));
+
+  // every supported gravity kernel against the scalar double path on the same positions
+  {
+    const GravitySolver savedSolver = gravitySolver;
+    gravitySolver = GravitySolver::Exact; // the kernels only serve the direct sum
+    const Simd::Isa savedIsa = gravityIsa;
+    const Simd::Precision savedPrecision = gravityPrecision;
+    gravityIsa = Simd::Isa::Scalar;
+    gravityPrecision = Simd::Precision::Double;
+    world.computeForces();
+    const std::vector<Vector2> reference = world.forces();
+    double sum2 = 0;
+    for (const Vector2& f : reference) sum2 += (double)f.x * f.x + (double)f.y * f.y;
+    const double rms = std::sqrt(sum2 / std::max<size_t>(1, simulated));
+    for (int k = 0; k <= (int)Simd::supported; ++k){
+      for (int p = 0; p < (int)Simd::Precision::Count; ++p){
+        gravityIsa = (Simd::Isa)k;
+        gravityPrecision = (Simd::Precision)p;
+        BenchResult r = Measure(scene.name, "kernel", simulated, 1, []{ world.computeForces(); });
+        double worst = 0;
+        for (size_t j = 0; j < reference.size(); ++j){
+          Vector2 d = world.forces()[j] - reference[j];
+          worst = std::max(worst, std::sqrt((double)d.x * d.x + (double)d.y * d.y));
+        }
+        r.error = rms > 0 ? worst / rms : worst;
+        const double tolerance = gravityPrecision == Simd::Precision::Double ? 1e-5 : 1e-3;
+        if (!(r.error <= tolerance)){
+          std::fprintf(stderr, "%s: %s/%s kernel is off by %g (tolerance %g)\n", scene.name,
+                       Simd::isaNames[k], Simd::precisionNames[p], r.error, tolerance);
+          ++gCheckFailures;
+        }
+        PrintResult(opt, r);
+      }
+    }
+    gravityIsa = savedIsa;
+    gravityPrecision = savedPrecision;
+    gravitySolver = savedSolver;
+  }
+
+  // error against direct summation versus time; the reference covers a strided sample of bodies, as
+  // summing every body directly would dominate the run at large N
+  {
+    const GravitySolver savedSolver = gravitySolver;
+    const int savedOrder = fmmOrder;
+    Simd::Sources sources;
+    for (size_t j = 0; j < bodies.size(); ++j)
+      if (bodies.mass[j] != 0 && !bodies.flags[j].shouldRemove) sources.add(bodies.pos[j].x, bodies.pos[j].y, bodies.mass[j]);
+    sources.finish(Simd::Precision::Double);
+    const size_t stride = std::max<size_t>(1, simulated / 1000);
+    std::vector<size_t> sample;
+    std::vector<Vector2> reference;
+    size_t seen = 0;
+    for (size_t j = 0; j < bodies.size(); ++j){
+      if (!bodies.flags[j].simulated || bodies.flags[j].shouldRemove || bodies.mass[j] == 0) continue;
+      if (seen++ % stride != 0) continue;
+      double fx, fy;
+      Simd::field(gravityIsa, Simd::Precision::Double, sources, bodies.pos[j].x, bodies.pos[j].y, fx, fy);
+      sample.push_back(j);
+      reference.push_back(vector(fx, fy) * (gravitationalConstant * bodies.mass[j]));
+    }
+    double sum2 = 0;
+    for (const Vector2& f : reference) sum2 += (double)f.x * f.x + (double)f.y * f.y;
+    const double rms = std::sqrt(sum2 / std::max<size_t>(1, reference.size()));
+    auto accuracy = [&]{
+      BenchResult r = Measure(scene.name, "accuracy", simulated, opt.steps, []{ world.computeForces(); });
+      double worst = 0;
+      for (size_t k = 0; k < sample.size(); ++k){
+        Vector2 d = world.forces()[sample[k]] - reference[k];
+        worst = std::max(worst, std::sqrt((double)d.x * d.x + (double)d.y * d.y));
+      }
+      r.error = rms > 0 ? worst / rms : worst;
+      PrintResult(opt, r);
+    };
+    gravitySolver = GravitySolver::BarnesHut;
+    accuracy();
+    gravitySolver = GravitySolver::Fmm;
+    for (fmmOrder = 2; fmmOrder <= Fmm::MaxOrder; fmmOrder += 2) accuracy();
+    gravitySolver = savedSolver;
+    fmmOrder = savedOrder;
+  }
+  PrintResult(opt, Measure(scene.name, "collisions", simulated, opt.steps, []{ world.resolveCollisions(); }));
+  PrintResult(opt, Measure(scene.name, "substep", simulated, opt.steps, [&]{ world.substep(dt); }));
+  PrintResult(opt, Measure(scene.name, "frame", bodies.size(), opt.steps, [&]{
+    bodies.removeMarked();
+    world.step(1.0 / 60.0);
+    particles.update(1.0 / 60.0);
+    for (size_t j = 0; j < bodies.size(); ++j){
+      if (bodies.flags[j].shouldRemove) continue;
+      bodies.handle[j]->tick(1.0 / 60.0);
+    }
+  }));
+
+  // particle spawning and update: one Firework-sized burst per step, timed per live particle
+  {
+    particles.clear();
+    size_t emitted = 0;
+    uint64_t bursts = 0;
+    BenchResult r = Measure(scene.name, "explosion", 1, opt.steps, [&]{
+      size_t before = particles.size();
+      explosion(emitterStream(bursts++), vector(0, 0), WHITE, 3, 50, 300, 100);
+      emitted += particles.size() - before;
+      particles.update(1.0 / 60.0);
+    });
+    r.bodies = std::max<size_t>(1, emitted / std::max(1, opt.steps));
+    PrintResult(opt, r);
+  }
+
+  // what the simulation thread copies out for the renderer once per frame
+  SimView view;
+  view.capture();
+  PrintResult(opt, Measure(scene.name, "publish", bodies.size() + particles.size(), opt.steps, [&]{ view.capture(); }));
+
+  if (opt.draw){
+    PrintResult(opt, Measure(scene.name, "draw", bodies.size() + particles.size(), opt.steps, [&]{
+      BeginDrawing();
+      ClearBackground(BLACK);
+      shapeBatch.begin();
+      DrawView(view);
+      EndDrawing();
+    }));
+    // zoomed 100x into the scene origin: nearly everything is off screen and should be culled
+    Vector2 savedPos = windowPos;
+    double savedScale = windowScale;
+    windowScale = savedScale / 100;
+    windowPos = vector(-screenWidth, -screenHeight) * windowScale / 2;
+    PrintResult(opt, Measure(scene.name, "draw_zoomed", bodies.size() + particles.size(), opt.steps, [&]{
+      BeginDrawing();
+      ClearBackground(BLACK);
+      shapeBatch.begin();
+      DrawView(view);
+      EndDrawing();
+    }));
+    std::fprintf(stderr, "%s draw_zoomed: %zu drawn, %zu culled\n", scene.name, shapeBatch.drawn(), shapeBatch.culled);
+    windowPos = savedPos;
+    windowScale = savedScale;
+  }
+
+  const char* path = "bench_scene.csv";
+  size_t rows = SimulatedCount(); // particles are not saved
+  SceneCapture capture;
+  CaptureScene(capture); // warm the rows buffer, as AsyncSceneSaver keeps it between saves
+  PrintResult(opt, Measure(scene.name, "csv_capture", rows, 1, [&]{ CaptureScene(capture); }));
+  PrintResult(opt, Measure(scene.name, "csv_save", rows, 1, [&]{ SaveSceneCSV(path); }));
+  PrintResult(opt, Measure(scene.name, "csv_load", rows, 1, [&]{ LoadSceneCSV(path); }));
+  std::remove(path);
+
+  const char* binPath = "bench_scene.phys";
+  PrintResult(opt, Measure(scene.name, "bin_save", rows, 1, [&]{ SaveSceneBinary(binPath, false); }));
+  PrintResult(opt, Measure(scene.name, "bin_load", rows, 1, [&]{ LoadSceneBinary(binPath); }));
+  PrintResult(opt, Measure(scene.name, "binz_save", rows, 1, [&]{ SaveSceneBinary(binPath, true); }));
+  PrintResult(opt, Measure(scene.name, "binz_load", rows, 1, [&]{ LoadSceneBinary(binPath); }));
+  std::remove(binPath);
+  ClearScene();
+}
+
+// The same emitter on two consecutive body ticks with no substep in between (1 ms simulation ticks are
+// shorter than fixedDt) must get different debris
+static void CheckEmitterStreams(){
+  world.seed(1);
+  std::vector<Vector2> pos[2];
+  std::vector<float> radius[2];
+  std::vector<Color> color;
+  for (int t = 0; t < 2; ++t){
+    particles.clear();
+    ++world.ticks;
+    explosion(emitterStream(0), vector(0, 0), WHITE, 3, 50, 30, 30);
+    particles.update(1.0 / 60.0); // spreads the debris by its speeds
+    particles.capture(pos[t], radius[t], color);
+  }
+  particles.clear();
+  bool same = radius[0] == radius[1];
+  for (size_t k = 0; same && k < pos[0].size(); ++k) same = pos[0][k].x == pos[1][k].x && pos[0][k].y == pos[1][k].y;
+  if (same){
+    std::fprintf(stderr, "explosion debris repeats between ticks of one substep\n");
+    ++gCheckFailures;
+  }
+}
+
+int main(int argc, char** argv){
+  BenchOptions opt;
+  for (int i = 1; i < argc; ++i){
+    const char* a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(a, "--n") == 0 && hasValue) opt.n = (size_t)std::atoll(argv[++i]);
+    else if (std::strcmp(a, "--steps") == 0 && hasValue) opt.steps = std::atoi(argv[++i]);
+    else if (std::strcmp(a, "--seed") == 0 && hasValue) opt.seed = (unsigned)std::atoi(argv[++i]);
+    else if (std::strcmp(a, "--threads") == 0 && hasValue) threadPool.resize((unsigned)std::atoi(argv[++i]));
+    else if (std::strcmp(a, "--theta") == 0 && hasValue) barnesHutTheta = std::atof(argv[++i]);
+    else if (std::strcmp(a, "--scene") == 0 && hasValue) opt.scene = argv[++i];
+    else if (std::strcmp(a, "--integrator") == 0 && hasValue){
+      if (!ParseIntegrator(argv[++i], integrator)){ std::fprintf(stderr, "unknown integrator %s\n", argv[i]); return 2; }
+    }
+    else if (std::strcmp(a, "--kernel") == 0 && hasValue){
+      if (!Simd::parseIsa(argv[++i], gravityIsa)){ std::fprintf(stderr, "unknown kernel %s\n", argv[i]); return 2; }
+    }
+    else if (std::strcmp(a, "--precision") == 0 && hasValue){
+      if (!Simd::parsePrecision(argv[++i], gravityPrecision)){ std::fprintf(stderr, "unknown precision %s\n", argv[i]); return 2; }
+    }
+    else if (std::strcmp(a, "--solver") == 0 && hasValue){
+      if (!ParseGravitySolver(argv[++i], gravitySolver)){ std::fprintf(stderr, "unknown solver %s\n", argv[i]); return 2; }
+    }
+    else if (std::strcmp(a, "--order") == 0 && hasValue) fmmOrder = std::atoi(argv[++i]);
+    else if (std::strcmp(a, "--fmm-theta") == 0 && hasValue) fmmTheta = std::atof(argv[++i]);
+    else if (std::strcmp(a, "--exact") == 0) gravitySolver = GravitySolver::Exact;
+    else if (std::strcmp(a, "--no-draw") == 0) opt.draw = false;
+    else {
+      std::fprintf(stderr, "usage: physics_bench [--n N] [--steps S] [--seed X] [--threads T] [--theta θ] [--exact] [--integrator name] [--scene name]\n"
+                           "                     [--solver exact|barnes-hut|fmm] [--order p] [--fmm-theta θ]\n"
+                           "                     [--kernel scalar|sse2|avx2|avx512] [--precision double|float] [--no-draw]\n");
+      return 2;
+    }
+  }
+
+  if (opt.draw){
+    SetTraceLogLevel(LOG_NONE);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(screenWidth, screenHeight, "physics_bench");
+  }
+  CheckEmitterStreams();
+  for (const auto& scene : kScenes){
+    if (!opt.scene.empty() && opt.scene != scene.name) continue;
+    RunScene(opt, scene);
+  }
+  if (opt.draw) CloseWindow();
+  return gCheckFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "raylib.h"
+#include <vector>
+#include <utility>
+
+class Object;
+
+// Shape kind of a body; indexes the pair handler tables (Collision::overlapTable/collideTable)
+enum class Shape : unsigned char { Circle, Rectangle, Count };
+
+// Per-body flags, kept as plain bools so the editor can bind them directly
+struct BodyFlags {
+  bool gravityAffected = false;
+  bool fixed = false;
+  bool leaveTrail = false;
+  bool shouldRemove = false;
+  bool simulated = false; // integrated by World::step
+};
+
+// Structure-of-arrays storage for the hot per-body fields. Objects are thin handles that keep
+// their slot index; slots stay in creation order and are compacted once per frame by removeMarked().
+// Never hold a reference into these arrays across anything that can create a body.
+class BodyStore {
+  public:
+  std::vector<Vector2> pos;
+  std::vector<Vector2> prevPos; // pos before the last substep, for render interpolation
+  std::vector<Vector2> speed;
+  std::vector<double> mass;
+  std::vector<double> radius;   // circles; 0 for rectangles
+  std::vector<Vector2> sides;   // rectangles; {0,0} for circles
+  std::vector<double> frictionFactor;
+  std::vector<float> elasticity;
+  std::vector<BodyFlags> flags;
+  std::vector<Shape> shape;
+  std::vector<Object*> handle;
+
+  size_t size() const { return handle.size(); }
+  bool empty() const { return handle.empty(); }
+
+  void reserve(size_t n){
+    pos.reserve(n); prevPos.reserve(n); speed.reserve(n); mass.reserve(n); radius.reserve(n); sides.reserve(n);
+    frictionFactor.reserve(n); elasticity.reserve(n); flags.reserve(n); shape.reserve(n); handle.reserve(n);
+  }
+  int attach(Object* o, Shape s){
+    pos.push_back({0, 0});
+    prevPos.push_back({0, 0});
+    speed.push_back({0, 0});
+    mass.push_back(0);
+    radius.push_back(0);
+    sides.push_back({0, 0});
+    frictionFactor.push_back(0);
+    elasticity.push_back(0.5f);
+    flags.push_back(BodyFlags());
+    shape.push_back(s);
+    handle.push_back(o);
+    return (int)handle.size() - 1;
+  }
+  // Objects register themselves on construction; spawn just makes the ownership explicit at call sites
+  template<class T, class... Args>
+  T* spawn(Args&&... args){
+    return new T(std::forward<Args>(args)...);
+  }
+  void removeMarked(); // deletes every handle flagged shouldRemove, keeping the order of the rest
+  void clear();        // deletes every handle
+};
+
+BodyStore bodies;
@@ -0,0 +1,242 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+// Uniform-grid broadphase. Boxes are hashed into square cells sized from the average box extent,
+// overlapping boxes sharing a cell become candidate pairs for the narrowphase resolvers.
+namespace Broadphase {
+
+struct Box {
+  double minX, minY, maxX, maxY;
+};
+
+inline bool overlaps(const Box& a, const Box& b){
+  return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+class Grid {
+  public:
+  static const int MAX_CELLS_PER_BOX = 64; // bigger boxes are paired against everything instead
+
+  size_t candidatePairs = 0; // pairs handed to the narrowphase in the last build
+  size_t prunedPairs = 0;    // pairs skipped compared to testing every pair
+
+  void clear(){
+    boxes.clear();
+  }
+  int add(const Box& b){
+    boxes.push_back(b);
+    return (int)boxes.size() - 1;
+  }
+  size_t size() const { return boxes.size(); }
+
+  void build(){
+    const int n = (int)boxes.size();
+    entries.clear();
+    large.clear();
+    pairs.clear();
+    candidatePairs = 0;
+    prunedPairs = 0;
+    offsets.assign(n + 1, 0);
+    neighbours.clear();
+    if (n == 0) return;
+
+    double extent = 0;
+    for (const auto& b : boxes) extent += std::max(b.maxX - b.minX, b.maxY - b.minY);
+    cellSize = std::max(2.0 * extent / n, 1e-3);
+
+    for (int i = 0; i < n; ++i){
+      const Box& b = boxes[i];
+      long long x0 = cell(b.minX), x1 = cell(b.maxX);
+      long long y0 = cell(b.minY), y1 = cell(b.maxY);
+      if ((x1 - x0 + 1) * (y1 - y0 + 1) > MAX_CELLS_PER_BOX){
+        large.push_back(i);
+        continue;
+      }
+      for (long long y = y0; y <= y1; ++y)
+        for (long long x = x0; x <= x1; ++x)
+          entries.push_back({key(x, y), i});
+    }
+    std::sort(entries.begin(), entries.end());
+
+    for (size_t s = 0; s < entries.size(); ){
+      size_t e = s;
+      while (e < entries.size() && entries[e].first == entries[s].first) ++e;
+      for (size_t a = s; a < e; ++a){
+        for (size_t b = a + 1; b < e; ++b){
+          int i = entries[a].second, j = entries[b].second;
+          if (!overlaps(boxes[i], boxes[j])) continue;
+          // report each pair only from the cell holding the corner of the overlap region
+          double ox = std::max(boxes[i].minX, boxes[j].minX);
+          double oy = std::max(boxes[i].minY, boxes[j].minY);
+          if (key(cell(ox), cell(oy)) != entries[s].first) continue;
+          pairs.push_back({i, j});
+        }
+      }
+      s = e;
+    }
+    for (size_t a = 0; a < large.size(); ++a){
+      int i = large[a];
+      for (int j = 0; j < n; ++j){
+        if (j == i) continue;
+        bool jLarge = std::binary_search(large.begin(), large.end(), j);
+        if (jLarge && j < i) continue; // large-large pairs once
+        if (overlaps(boxes[i], boxes[j])) pairs.push_back({i, j});
+      }
+    }
+
+    // neighbour lists in CSR form, both directions, sorted by insertion order
+    for (const auto& p : pairs){ offsets[p.first + 1]++; offsets[p.second + 1]++; }
+    for (int i = 0; i < n; ++i) offsets[i + 1] += offsets[i];
+    neighbours.resize(offsets[n]);
+    std::vector<int>& fill = scratch;
+    fill.assign(offsets.begin(), offsets.end() - 1);
+    for (const auto& p : pairs){
+      neighbours[fill[p.first]++] = p.second;
+      neighbours[fill[p.second]++] = p.first;
+    }
+    for (int i = 0; i < n; ++i) std::sort(neighbours.begin() + offsets[i], neighbours.begin() + offsets[i + 1]);
+
+    candidatePairs = pairs.size();
+    size_t all = (size_t)n * (size_t)(n - 1) / 2;
+    prunedPairs = all - candidatePairs;
+  }
+
+  const int* begin(int i) const { return neighbours.data() + offsets[i]; }
+  const int* end(int i) const { return neighbours.data() + offsets[i + 1]; }
+
+  private:
+  double cellSize = 1;
+  std::vector<Box> boxes;
+  std::vector<std::pair<uint64_t, int>> entries;
+  std::vector<std::pair<int, int>> pairs;
+  std::vector<int> large;
+  std::vector<int> offsets;
+  std::vector<int> neighbours;
+  std::vector<int> scratch;
+
+  long long cell(double v) const { return (long long)std::floor(v / cellSize); }
+  static uint64_t key(long long x, long long y){
+    return ((uint64_t)(uint32_t)(int32_t)x << 32) | (uint64_t)(uint32_t)(int32_t)y;
+  }
+};
+
+// Bounding-volume tree over a fixed set of boxes for point and region queries (editor picking).
+// The boxes are sorted once along a Morton curve of their centres, and every node is a contiguous
+// half of its parent's range, so building is one integer sort plus a linear pass. The tree is
+// balanced and a query visits O(log N) nodes plus the boxes it reports, as long as boxes don't pile up.
+// refit() moves the same boxes without sorting again: queries stay exact, and only get slower as the
+// boxes drift away from the order they were built in.
+class BoxTree {
+  public:
+  static const int LEAF_SIZE = 8;
+
+  void build(const std::vector<Box>& b){
+    boxes.assign(b.begin(), b.end());
+    const int n = (int)boxes.size();
+    nodes.clear();
+    order.clear();
+    if (n == 0) return;
+    double minX = 1e300, minY = 1e300, maxX = -1e300, maxY = -1e300;
+    for (const Box& x : boxes){
+      minX = std::min(minX, x.minX + x.maxX); maxX = std::max(maxX, x.minX + x.maxX);
+      minY = std::min(minY, x.minY + x.maxY); maxY = std::max(maxY, x.minY + x.maxY);
+    }
+    const double sx = 65535.0 / std::max(maxX - minX, 1e-300), sy = 65535.0 / std::max(maxY - minY, 1e-300);
+    keys.resize(n);
+    for (int i = 0; i < n; ++i){
+      uint32_t qx = (uint32_t)((boxes[i].minX + boxes[i].maxX - minX) * sx);
+      uint32_t qy = (uint32_t)((boxes[i].minY + boxes[i].maxY - minY) * sy);
+      keys[i] = (uint64_t)(spread(qx) | spread(qy) << 1) << 32 | (uint32_t)i;
+    }
+    std::sort(keys.begin(), keys.end());
+    order.resize(n);
+    for (int i = 0; i < n; ++i) order[i] = (int)(uint32_t)keys[i];
+    nodes.reserve(2 * (n / LEAF_SIZE + 1));
+    split(0, n);
+  }
+  // new positions for the boxes of the last build(), same count and order; O(N)
+  void refit(const std::vector<Box>& b){
+    boxes.assign(b.begin(), b.end());
+    // nodes are stored parent first, so children are refitted before their parent
+    for (size_t id = nodes.size(); id-- > 0;){
+      Node& nd = nodes[id];
+      if (nd.left < 0){
+        nd.bounds = boxes[order[nd.begin]];
+        for (int k = nd.begin + 1; k < nd.end; ++k) nd.bounds = merge(nd.bounds, boxes[order[k]]);
+      } else {
+        nd.bounds = merge(nodes[nd.left].bounds, nodes[nd.right].bounds);
+      }
+    }
+  }
+  size_t size() const { return boxes.size(); }
+
+  // f(i) for every box overlapping region, in no particular order
+  template<class F>
+  void query(const Box& region, F f) const {
+    if (nodes.empty()) return;
+    int stack[128]; // depth is at most log2(N) + 1
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0){
+      const Node& nd = nodes[stack[--top]];
+      if (!overlaps(nd.bounds, region)) continue;
+      if (nd.left < 0){
+        for (int k = nd.begin; k < nd.end; ++k)
+          if (overlaps(boxes[order[k]], region)) f(order[k]);
+      } else {
+        stack[top++] = nd.right;
+        stack[top++] = nd.left;
+      }
+    }
+  }
+  template<class F>
+  void query(double x, double y, F f) const { query(Box{x, y, x, y}, f); }
+
+  private:
+  struct Node {
+    Box bounds;
+    int begin, end;  // range of `order` below this node
+    int left, right; // children, -1 for leaves
+  };
+  std::vector<Box> boxes;
+  std::vector<uint64_t> keys;
+  std::vector<int> order;
+  std::vector<Node> nodes;
+
+  static Box merge(const Box& a, const Box& b){
+    return {std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY)};
+  }
+
+  // 16-bit value with a zero bit inserted after each bit
+  static uint32_t spread(uint32_t v){
+    v &= 0xffff;
+    v = (v | v << 8) & 0x00ff00ff;
+    v = (v | v << 4) & 0x0f0f0f0f;
+    v = (v | v << 2) & 0x33333333;
+    v = (v | v << 1) & 0x55555555;
+    return v;
+  }
+
+  int split(int begin, int end){
+    const int id = (int)nodes.size();
+    nodes.push_back({boxes[order[begin]], begin, end, -1, -1});
+    Box bounds = boxes[order[begin]];
+    if (end - begin <= LEAF_SIZE){
+      for (int k = begin + 1; k < end; ++k) bounds = merge(bounds, boxes[order[k]]);
+    } else {
+      const int l = split(begin, begin + (end - begin) / 2);
+      const int r = split(begin + (end - begin) / 2, end);
+      bounds = merge(nodes[l].bounds, nodes[r].bounds);
+      nodes[id].left = l;
+      nodes[id].right = r;
+    }
+    nodes[id].bounds = bounds;
+    return id;
+  }
+};
+
+} // namespace Broadphase
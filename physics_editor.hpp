@@ -1,10 +1,16 @@
 #pragma once
 #include "raylib.h"
 #include "physics_engine.hpp"
-#include <sstream>
+#include "physics_sim.hpp"
+#include "physics_text.hpp"
+#include "physics_broadphase.hpp"
+#include "physics_generators.hpp"
+#include <map>
+#include <unordered_set>
+#include <vector>
 #include <string>
 
-extern std::list<Object*> objectList;
+extern BodyStore bodies;
 extern double windowScale;
 extern Vector2 windowPos;
 
@@ -27,7 +33,16 @@ double getKeyScale(){
 namespace PhysEditor {
 
 // Right-click opens editor. If right-clicked empty space, edit template for new objects.
-// Left-click uses the template to create a new PhysicsCircularObject at the click position.
+// Left-click uses the template to create a new PhysicsCircularObject at the click position, or a whole
+// group of them when a generator is chosen.
+// The editor runs on the render thread: it reads bodies from sim.view() and changes them by posting
+// commands, addressing them by uuid.
+
+static const uint64_t NoBody = ~0ull;
+
+// What a left click creates from the template
+enum class Generator { Single, Disc, Grid, Cloud, Count };
+static const Str generatorNames[(int)Generator::Count] = { Str::GenSingle, Str::GenDisc, Str::GenGrid, Str::GenCloud };
 
 struct TemplateProps {
     // Only used when editing template (for new creations)
@@ -40,20 +55,32 @@ struct TemplateProps {
     Vector2 speed = {0, 0};
     bool leaveTrail = false;
     bool fixed = false;
+    // generators, also used for rings around an object
+    Generator generator = Generator::Single;
+    double count = 1000;
+    double size = 2000;             // disc/cloud/ring radius, grid width
+    double centralMass = 1e16;      // body at the centre of a disc
 };
 
 struct State {
     bool visible = false;
-    bool editingTemplate = true;    // true => editing template; false => editing selected object
-    Object* selected = nullptr;     // selected object when editingTemplate == false
+    bool editingTemplate = true;    // true => editing template; false => editing selected object(s)
+    uint64_t selected = NoBody;     // uuid of the selected object when editingTemplate == false
+    std::unordered_set<uint64_t> selection; // uuids from a right-drag rectangle, when selected == NoBody
+    SceneRow bulk{};                // values shown for the selection; edits apply to every body in it
+    bool bulkCircles = false;       // the selection has circles, so radius can be edited
     TemplateProps tpl{};            // editable template for new objects
     // UI
-    Rectangle panel{20, 60, 360, 420};
+    Rectangle panel{20, 60, 360, 540};
     bool dragging = false;
     Vector2 dragOffset{0,0};
     bool awaitingOrbitTarget = false;
+    bool rightDragging = false;     // right button held; a drag selects, a click picks
+    Vector2 rightStart{0,0};
 };
 
+static const float SelectDragPixels = 4; // right-button travel that turns a click into a rectangle
+
 static State& S() { static State s; return s; }
 
 // ----------------- Small UI helpers -----------------
@@ -64,15 +91,22 @@ static bool PointInRect(Vector2 p, const Rectangle& r){
 static bool DrawBtn(const Rectangle& r, const char* txt){
     DrawRectangleRec(r, (Color){40,40,40,255});
     DrawRectangleLinesEx(r, 1.0f, (Color){200,200,200,255});
-    int tw = MeasureText(txt, 16);
-    DrawTextEx(uiFont, txt, vector(r.x + (r.width - tw)/2, r.y + 2), 16, 1.0f, WHITE);
+    const TextLayout& t = labelCache.get(txt, 16);
+    t.draw(vector(r.x + (r.width - t.extent().x)/2, r.y + 2), WHITE);
     return (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && PointInRect(GetMousePosition(), r));
 }
 
+// Value column of a row, formatted again only when the value shown under that label changes
+static const TextLayout& ValueText(const char* name, double val, bool scientific, int precision = 4){
+    static std::map<const char*, CachedText<double,bool,int>> cache;
+    return cache.try_emplace(name, 18.0f).first->second.update(val, scientific, precision, [&](std::ostream& oss){
+        oss.setf(scientific?std::ios::scientific:std::ios::fixed); oss.precision(precision); oss << val;
+    });
+}
+
 static void DrawValueRowF(const char* name, float& val, float step, float x, float& y){
-    DrawTextEx(uiFont,name, vector(x, y), 18, 1.0f, WHITE);
-    std::ostringstream oss; oss.setf(std::ios::fixed); oss.precision(4); oss << val;
-    DrawTextEx(uiFont,oss.str().c_str(), vector(x+160, y), 18, 1.0f, (Color){180,220,255,255});
+    labelCache.get(name, 18).draw(vector(x, y), WHITE);
+    ValueText(name, val, false).draw(vector(x+160, y), (Color){180,220,255,255});
     Rectangle minusR = {x+260, y, 24, 24};
     Rectangle plusR  = {x+290, y, 24, 24};
     double keyscale = getKeyScale();
@@ -82,9 +116,8 @@ static void DrawValueRowF(const char* name, float& val, float step, float x, flo
 }
 
 static void DrawValueRowD(const char* name, double& val, double step, float x, float& y){
-    DrawTextEx(uiFont,name, vector(x, y), 18, 1.0f, WHITE);
-    std::ostringstream oss; oss.setf(val>10e9?std::ios::scientific:std::ios::fixed); oss.precision(4); oss << val;
-    DrawTextEx(uiFont,oss.str().c_str(), vector(x+160, y), 18, 1.0f, (Color){180,220,255,255});
+    labelCache.get(name, 18).draw(vector(x, y), WHITE);
+    ValueText(name, val, val>10e9).draw(vector(x+160, y), (Color){180,220,255,255});
     Rectangle minusR = {x+260, y, 24, 24};
     Rectangle plusR  = {x+290, y, 24, 24};
     double keyscale = getKeyScale();
@@ -93,8 +126,19 @@ static void DrawValueRowD(const char* name, double& val, double step, float x, f
     y += 28;
 }
 
+// Whole number that halves and doubles, for counts spanning orders of magnitude
+static void DrawCountRow(const char* name, double& val, float x, float& y){
+    labelCache.get(name, 18).draw(vector(x, y), WHITE);
+    ValueText(name, val, false, 0).draw(vector(x+160, y), (Color){180,220,255,255});
+    Rectangle minusR = {x+260, y, 24, 24};
+    Rectangle plusR  = {x+290, y, 24, 24};
+    if (DrawBtn(minusR, "-")) val = std::max(1.0, std::floor(val/2));
+    if (DrawBtn(plusR,  "+")) val = val*2;
+    y += 28;
+}
+
 static void DrawCheckRow(const char* name, bool& b, float x, float& y){
-    DrawTextEx(uiFont,name, vector(x,y), 18, 1.0f, WHITE);
+    labelCache.get(name, 18).draw(vector(x,y), WHITE);
     Rectangle r = {x+160, y, 24, 24};
     DrawRectangleRec(r, b ? (Color){80,160,80,255} : (Color){60,60,60,255});
     DrawRectangleLinesEx(r, 1, (Color){200,200,200,255});
@@ -104,7 +148,7 @@ static void DrawCheckRow(const char* name, bool& b, float x, float& y){
 
 static void DrawRGBRow(const char* name, unsigned char& ch, float x, float& y){
     float fx = (float)ch;
-    DrawTextEx(uiFont,name, vector(x,y), 18, 1.0f, WHITE);
+    labelCache.get(name, 18).draw(vector(x,y), WHITE);
     Rectangle bar = {x+160, y+8, 160, 8};
     DrawRectangleRec(bar, (Color){90,90,90,255});
     float knobX = bar.x + (fx/255.0f)*bar.width - 4;
@@ -119,63 +163,220 @@ static void DrawRGBRow(const char* name, unsigned char& ch, float x, float& y){
 }
 
 // ----------------- Picking -----------------
-static Object* PickObjectAtScreen(Vector2 mp){
+// The simulation thread publishes each view with a box tree over its massive bodies (SimView::pickTree),
+// so a pick is O(log N) and never rebuilds anything on the render thread.
+
+// uuid of the smallest body under the cursor in the current view, or NoBody
+static uint64_t PickObjectAtScreen(Vector2 mp){
+    const SimView& v = sim.view();
     Vector2 world = mp*windowScale + windowPos;
-    Object* best = nullptr;
+    uint64_t best = NoBody;
     double bestKey = 1e300;
-    for (auto* o : objectList){
-        if (auto c = dynamic_cast<CircularObject*>(o)){
-            double d = distance(world, c->pos);
-            if (d <= c->radius){
-                if (c->radius < bestKey){ bestKey = c->radius; best = o; }
-            }
-        } else if (auto r = dynamic_cast<RectangularObject*>(o)){
-            if (CheckCollisionPointRec(world, r->rect())){
-                double key = (double)r->sides.x * (double)r->sides.y; // smaller first
-                if (key < bestKey){ bestKey = key; best = o; }
-            }
+    v.pickTree.query(world.x, world.y, [&](int i){
+        const int k = v.pickRows[i];
+        const SceneRow& row = v.scene.rows[k];
+        if (row.width == 0){
+            double radius = row.height/2;
+            if (distance(world, row.pos) <= radius && radius < bestKey){ bestKey = radius; best = v.uuid[k]; }
+        } else {
+            double key = row.width * row.height; // smaller first
+            if (key < bestKey){ bestKey = key; best = v.uuid[k]; }
         }
-    }
+    });
     return best;
 }
 
+// rows of every body touching the screen rectangle between corners a and b, in row order
+static std::vector<int> PickObjectsInScreenRect(Vector2 a, Vector2 b){
+    const SimView& v = sim.view();
+    Vector2 wa = a*windowScale + windowPos, wb = b*windowScale + windowPos;
+    Broadphase::Box region = {std::min(wa.x, wb.x), std::min(wa.y, wb.y), std::max(wa.x, wb.x), std::max(wa.y, wb.y)};
+    std::vector<int> rows;
+    v.pickTree.query(region, [&](int i){
+        const int k = v.pickRows[i];
+        const SceneRow& row = v.scene.rows[k];
+        if (row.width == 0){
+            // circle against the rectangle, not just its bounding box
+            double dx = row.pos.x - std::clamp((double)row.pos.x, region.minX, region.maxX);
+            double dy = row.pos.y - std::clamp((double)row.pos.y, region.minY, region.maxY);
+            if (dx*dx + dy*dy > row.height*row.height/4) return;
+        }
+        rows.push_back(k);
+    });
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+// Runs edit(o) on the simulation thread if the body still exists by then
+template<class F>
+static void PostEdit(uint64_t id, F edit){
+    sim.post([id, edit]{ if (Object* o = FindBody(id)) edit(o); });
+}
+
+// Runs edit(o) on the simulation thread for every body of ids that still exists, in one pass
+template<class F>
+static void PostEditAll(const std::unordered_set<uint64_t>& ids, F edit){
+    sim.post([ids, edit]{
+        for (size_t j = 0; j < bodies.size(); ++j)
+            if (!bodies.flags[j].shouldRemove && ids.count(bodies.handle[j]->uuid)) edit(bodies.handle[j]);
+    });
+}
+
 // ----------------- Public API -----------------
 inline void Init(){ /* nothing yet */ }
 
 inline void OnRightClick(Vector2 mouseScreen){
     State& st = S();
-    Object* picked = PickObjectAtScreen(mouseScreen);
-    if (picked){
+    st.selection.clear();
+    uint64_t picked = PickObjectAtScreen(mouseScreen);
+    if (picked != NoBody){
         st.selected = picked;
         st.editingTemplate = false;
         st.visible = true;
     } else {
-        st.selected = nullptr;
+        st.selected = NoBody;
         st.editingTemplate = true;
         st.visible = true;
     }
 }
 
+// Right button: a click picks like OnRightClick, a drag selects every body in the dragged rectangle
+inline void OnRightPress(Vector2 mouseScreen){
+    State& st = S();
+    st.rightDragging = true;
+    st.rightStart = mouseScreen;
+}
+
+inline void OnRightRelease(Vector2 mouseScreen){
+    State& st = S();
+    if (!st.rightDragging) return;
+    st.rightDragging = false;
+    if (std::fabs(mouseScreen.x - st.rightStart.x) < SelectDragPixels && std::fabs(mouseScreen.y - st.rightStart.y) < SelectDragPixels){
+        OnRightClick(st.rightStart);
+        return;
+    }
+    const SimView& v = sim.view();
+    std::vector<int> rows = PickObjectsInScreenRect(st.rightStart, mouseScreen);
+    st.selection.clear();
+    st.selected = NoBody;
+    st.awaitingOrbitTarget = false;
+    if (rows.empty()) { st.visible = false; return; }
+    // the panel starts from the first circle's values (the first body's without circles)
+    st.bulk = v.scene.rows[rows[0]];
+    st.bulkCircles = false;
+    for (int k : rows){
+        st.selection.insert(v.uuid[k]);
+        if (!st.bulkCircles && v.scene.rows[k].width == 0){ st.bulk = v.scene.rows[k]; st.bulkCircles = true; }
+    }
+    st.editingTemplate = false;
+    st.visible = true;
+}
+
+// Outlines the selection and the rectangle being dragged; drawn under the panel
+static void DrawSelection(const State& st){
+    if (st.rightDragging){
+        Vector2 m = GetMousePosition();
+        Rectangle r = {std::min(m.x, st.rightStart.x), std::min(m.y, st.rightStart.y), std::fabs(m.x - st.rightStart.x), std::fabs(m.y - st.rightStart.y)};
+        if (r.width >= SelectDragPixels || r.height >= SelectDragPixels){
+            DrawRectangleRec(r, (Color){140,140,160,40});
+            DrawRectangleLinesEx(r, 1, (Color){140,140,160,255});
+        }
+    }
+    if (!st.visible || st.editingTemplate || st.selection.empty()) return;
+    const SimView& v = sim.view();
+    const float inv = (float)(1.0 / windowScale);
+    for (size_t k = 0; k < v.uuid.size(); ++k){
+        if (!st.selection.count(v.uuid[k])) continue;
+        Broadphase::Box b = RowBox(v.scene.rows[k]);
+        Vector2 d = v.drawPos[k] - v.scene.rows[k].pos; // boxes follow the interpolated position
+        DrawRectangleLinesEx({(float)(b.minX + d.x - windowPos.x)*inv - 2, (float)(b.minY + d.y - windowPos.y)*inv - 2,
+                              (float)(b.maxX - b.minX)*inv + 4, (float)(b.maxY - b.minY)*inv + 4}, 1, (Color){255,220,120,255});
+    }
+}
+
+// A body with the template's properties; simulation thread
+static PhysicsCircularObject* SpawnFromTemplate(const TemplateProps& tpl, Vector2 pos, Vector2 speed, double mass){
+    auto* obj = bodies.spawn<PhysicsCircularObject>(
+        pos,
+        speed,
+        tpl.color,
+        mass,
+        tpl.radius,
+        tpl.friction,
+        tpl.leaveTrail
+    );
+    obj->elasticity()      = tpl.elasticity;
+    obj->gravityAffected() = tpl.gravityAffected;
+    obj->fixed()           = tpl.fixed;
+    return obj;
+}
+
 // Call in your LMB handler to create from the template at mouse position
 inline bool HandleLeftClickCreate(Vector2 mouseScreen){
     State& st = S();
     Vector2 world = mouseScreen*windowScale + windowPos;
-    auto* obj = new PhysicsCircularObject(
-        world,
-        st.tpl.speed,
-        st.tpl.color,
-        st.tpl.mass,
-        st.tpl.radius,
-        st.tpl.friction,
-        st.tpl.leaveTrail
-    );
-    obj->elasticity = st.tpl.elasticity;
-    obj->gravityAffected = st.tpl.gravityAffected;
-    obj->fixed           = st.tpl.fixed;
-    objectList.push_back(obj);
+    TemplateProps tpl = st.tpl;
+    sim.post([world, tpl]{
+        const size_t n = (size_t)tpl.count;
+        auto place = [&tpl](Vector2 p, Vector2 v){ SpawnFromTemplate(tpl, p, v, tpl.mass); };
+        auto placeMoving = [&tpl](Vector2 p, Vector2){ SpawnFromTemplate(tpl, p, tpl.speed, tpl.mass); };
+        switch (tpl.generator){
+            case Generator::Disc:
+                SpawnFromTemplate(tpl, world, tpl.speed, tpl.centralMass);
+                SceneGen::KeplerDisc(n, tpl.size*0.1, tpl.size, tpl.centralMass, world, tpl.speed, place);
+                break;
+            case Generator::Grid: SceneGen::Grid(n, tpl.size, world, placeMoving); break;
+            case Generator::Cloud: SceneGen::Cloud(n, tpl.size, world, placeMoving); break;
+            default: SpawnFromTemplate(tpl, world, tpl.speed, tpl.mass); break;
+        }
+    });
     return true;
 }
 
+// Template bodies on one circular orbit around the body with this uuid, sized by the generator settings
+static void PostRing(uint64_t id, const TemplateProps& tpl){
+    PostEdit(id, [tpl](Object* centre){
+        SceneGen::Ring((size_t)tpl.count, tpl.size, centre->mass(), centre->pos(), centre->speed(),
+            [&tpl](Vector2 p, Vector2 v){ SpawnFromTemplate(tpl, p, v, tpl.mass); });
+    });
+}
+
+// Property rows of a body (or of a selection), edited in place
+static void DrawRowFields(SceneRow& row, double& radius, bool circle, float x, float& y){
+    DrawValueRowD(L(Str::EditorMass).data(),     row.mass,            1e3, x, y);
+    DrawValueRowD(L(Str::EditorFriction).data(), row.friction,        0.01, x, y);
+    DrawValueRowF(L(Str::EditorElasticity).data(), row.elasticity,    0.05f, x, y);
+    DrawCheckRow (L(Str::EditorGravity).data(),  row.flags.gravityAffected, x, y);
+    DrawValueRowF(L(Str::EditorSpeedX).data(),  row.speed.x,         10.0f, x, y);
+    DrawValueRowF(L(Str::EditorSpeedY).data(),  row.speed.y,         10.0f, x, y);
+    DrawCheckRow (L(Str::EditorTrail).data(),  row.flags.leaveTrail, x, y);
+    DrawCheckRow (L(Str::EditorFixed).data(),    row.flags.fixed, x, y);
+
+    if (circle){
+        DrawValueRowD(L(Str::EditorRadius).data(), radius, 1.0f, x, y);
+    }
+    DrawRGBRow(L(Str::EditorColorR).data(), row.color.r, x, y);
+    DrawRGBRow(L(Str::EditorColorG).data(), row.color.g, x, y);
+    DrawRGBRow(L(Str::EditorColorB).data(), row.color.b, x, y);
+}
+
+// Posts only what was touched, so e.g. a mass edit doesn't reset the speed the body has gained since;
+// post(edit) sends one edit to the body or to the whole selection
+template<class Post>
+static void PostChanges(const SceneRow& row, const SceneRow& was, double radius, Post post){
+    if (row.mass != was.mass) post([v = row.mass](Object* o){ o->mass() = v; });
+    if (row.friction != was.friction) post([v = row.friction](Object* o){ o->frictionFactor() = v; });
+    if (row.elasticity != was.elasticity) post([v = row.elasticity](Object* o){ o->elasticity() = v; });
+    if (row.flags.gravityAffected != was.flags.gravityAffected) post([v = row.flags.gravityAffected](Object* o){ o->gravityAffected() = v; });
+    if (row.speed.x != was.speed.x) post([v = row.speed.x](Object* o){ o->speed().x = v; });
+    if (row.speed.y != was.speed.y) post([v = row.speed.y](Object* o){ o->speed().y = v; });
+    if (row.flags.leaveTrail != was.flags.leaveTrail) post([v = row.flags.leaveTrail](Object* o){ o->leaveTrail() = v; });
+    if (row.flags.fixed != was.flags.fixed) post([v = row.flags.fixed](Object* o){ o->fixed() = v; });
+    if (radius != was.height/2) post([v = radius](Object* o){ if (o->shape() == Shape::Circle) static_cast<CircularObject*>(o)->radius() = v; });
+    if (row.color.r != was.color.r || row.color.g != was.color.g || row.color.b != was.color.b)
+        post([v = row.color](Object* o){ o->color.r = v.r; o->color.g = v.g; o->color.b = v.b; });
+}
+
 // Draw header + handle dragging
 static void DrawPanelFrame(State& st){
     Rectangle& panel = st.panel;
@@ -184,8 +385,9 @@ static void DrawPanelFrame(State& st){
 
     Rectangle title = {panel.x, panel.y, panel.width, 28};
     DrawRectangleRec(title, (Color){30,30,42,255});
-    const std::string titleTxt = st.editingTemplate ? L("editor.title.template") : L("editor.title.object");
-    DrawTextEx(uiFont, titleTxt.c_str(), vector(panel.x+10, panel.y+6), 16, 1.0f, WHITE);
+    const std::string_view titleTxt = st.editingTemplate ? L(Str::EditorTitleTemplate)
+                                    : st.selection.empty() ? L(Str::EditorTitleObject) : L(Str::EditorTitleSelection);
+    labelCache.get(titleTxt.data(), 16).draw(vector(panel.x+10, panel.y+6), WHITE);
 
     // Dragging
     if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && PointInRect(GetMousePosition(), title)){
@@ -202,6 +404,7 @@ static void DrawPanelFrame(State& st){
 // Draw panel and edit either template or live object
 inline void Draw(){
     State& st = S();
+    DrawSelection(st);
     if (!st.visible) return;
 
     DrawPanelFrame(st);
@@ -211,66 +414,94 @@ inline void Draw(){
 
     // Close button
     Rectangle closeR = { st.panel.x + st.panel.width - 96, st.panel.y + st.panel.height - 36, 80, 26 };
-    if (DrawBtn(closeR, L("btn.close").c_str())) st.visible = false;
+    if (DrawBtn(closeR, L(Str::BtnClose).data())) st.visible = false;
 
     if (st.editingTemplate){
-        DrawValueRowD(L("editor.mass").c_str(),     st.tpl.mass,     1e3, x, y);
-        DrawValueRowD(L("editor.friction").c_str(), st.tpl.friction, 0.01, x, y);
-        DrawValueRowF(L("editor.elasticity").c_str(), st.tpl.elasticity, 0.05f, x, y);
-        DrawCheckRow (L("editor.gravity").c_str(),  st.tpl.gravityAffected, x, y);
-        DrawValueRowF(L("editor.speed_x").c_str(),  st.tpl.speed.x, 10.0f, x, y);
-        DrawValueRowF(L("editor.speed_y").c_str(),  st.tpl.speed.y, 10.0f, x, y);
-        DrawCheckRow (L("editor.trail").c_str(),    st.tpl.leaveTrail, x, y);
-        DrawCheckRow (L("editor.fixed").c_str(),    st.tpl.fixed, x, y);
-        DrawValueRowF(L("editor.radius").c_str(),   st.tpl.radius,  1.0f, x, y);
-        DrawRGBRow   (L("editor.color_r").c_str(),  st.tpl.color.r, x, y);
-        DrawRGBRow   (L("editor.color_g").c_str(),  st.tpl.color.g, x, y);
-        DrawRGBRow   (L("editor.color_b").c_str(),  st.tpl.color.b, x, y);
+        DrawValueRowD(L(Str::EditorMass).data(),     st.tpl.mass,     1e3, x, y);
+        DrawValueRowD(L(Str::EditorFriction).data(), st.tpl.friction, 0.01, x, y);
+        DrawValueRowF(L(Str::EditorElasticity).data(), st.tpl.elasticity, 0.05f, x, y);
+        DrawCheckRow (L(Str::EditorGravity).data(),  st.tpl.gravityAffected, x, y);
+        DrawValueRowF(L(Str::EditorSpeedX).data(),  st.tpl.speed.x, 10.0f, x, y);
+        DrawValueRowF(L(Str::EditorSpeedY).data(),  st.tpl.speed.y, 10.0f, x, y);
+        DrawCheckRow (L(Str::EditorTrail).data(),    st.tpl.leaveTrail, x, y);
+        DrawCheckRow (L(Str::EditorFixed).data(),    st.tpl.fixed, x, y);
+        DrawValueRowF(L(Str::EditorRadius).data(),   st.tpl.radius,  1.0f, x, y);
+        DrawRGBRow   (L(Str::EditorColorR).data(),  st.tpl.color.r, x, y);
+        DrawRGBRow   (L(Str::EditorColorG).data(),  st.tpl.color.g, x, y);
+        DrawRGBRow   (L(Str::EditorColorB).data(),  st.tpl.color.b, x, y);
+
+        labelCache.get(L(Str::EditorGenerator).data(), 18).draw(vector(x, y), WHITE);
+        if (DrawBtn({x+160, y, 154, 24}, L(generatorNames[(int)st.tpl.generator]).data()))
+            st.tpl.generator = (Generator)(((int)st.tpl.generator + 1) % (int)Generator::Count);
+        y += 28;
+        if (st.tpl.generator != Generator::Single){
+            DrawCountRow (L(Str::EditorCount).data(), st.tpl.count, x, y);
+            DrawValueRowD(L(Str::EditorSize).data(),  st.tpl.size, 100, x, y);
+        }
+        if (st.tpl.generator == Generator::Disc)
+            DrawValueRowD(L(Str::EditorCentralMass).data(), st.tpl.centralMass, 1e15, x, y);
         // preview
         DrawCircle(st.panel.x + st.panel.width - 40, st.panel.y + 40, 10, st.tpl.color);
-    } else {
-        // Live-bound editing of the actual object fields
-        Object* o = st.selected;
-        if (!o || o->shouldRemove) { st.visible = false; st.selected = nullptr; return; }
-
-        DrawValueRowD(L("editor.mass").c_str(),     o->mass,            1e3, x, y);
-        DrawValueRowD(L("editor.friction").c_str(), o->frictionFactor,  0.01, x, y);
-        DrawValueRowF(L("editor.elasticity").c_str(), o->elasticity,      0.05f, x, y);
-        DrawCheckRow (L("editor.gravity").c_str(),  o->gravityAffected, x, y);
-        DrawValueRowF(L("editor.speed_x").c_str(),  o->speed.x,         10.0f, x, y);
-        DrawValueRowF(L("editor.speed_y").c_str(),  o->speed.y,         10.0f, x, y);
-        DrawCheckRow (L("editor.trail").c_str(),  o->leaveTrail, x, y);
-        DrawCheckRow (L("editor.fixed").c_str(),    o->fixed, x, y);
-
-        if (auto* c = dynamic_cast<CircularObject*>(o)){
-            DrawValueRowD(L("editor.radius").c_str(), c->radius, 1.0f, x, y);
+    } else if (!st.selection.empty()){
+        static CachedText<size_t> count{18};
+        labelCache.get(L(Str::EditorSelected).data(), 18).draw(vector(x, y), WHITE);
+        count.update(st.selection.size(), [&st](std::ostream& oss){ oss << st.selection.size(); }).draw(vector(x+160, y), (Color){180,220,255,255});
+        y += 28;
+
+        // each changed field goes to every selected body in one pass
+        SceneRow row = st.bulk;
+        double radius = row.height/2;
+        DrawRowFields(row, radius, st.bulkCircles, x, y);
+        PostChanges(row, st.bulk, radius, [&st](auto edit){ PostEditAll(st.selection, edit); });
+        row.height = radius*2;
+        st.bulk = row;
+
+        Rectangle delR = { x, st.panel.y + st.panel.height - 36, 80, 26 };
+        if (DrawBtn(delR, L(Str::BtnDelete).data())) {
+            PostEditAll(st.selection, [](Object* o){ o->shouldRemove() = true; });
+            st.selection.clear(); st.visible = false;
         }
-        DrawRGBRow(L("editor.color_r").c_str(), o->color.r, x, y);
-        DrawRGBRow(L("editor.color_g").c_str(), o->color.g, x, y);
-        DrawRGBRow(L("editor.color_b").c_str(), o->color.b, x, y);
+    } else {
+        // Edits a copy of the object's row in the current view; changed fields are posted back
+        const SimView& v = sim.view();
+        long k = v.find(st.selected);
+        if (k < 0) { st.visible = false; st.selected = NoBody; return; }
+        const SceneRow& was = v.scene.rows[k];
+        SceneRow row = was;
+        double radius = row.height/2;
+
+        DrawRowFields(row, radius, row.width == 0, x, y);
+        const uint64_t id = st.selected;
+        PostChanges(row, was, radius, [id](auto edit){ PostEdit(id, edit); });
+
+        // a ring of template bodies around this one, from the generator settings
+        DrawCountRow (L(Str::EditorCount).data(), st.tpl.count, x, y);
+        DrawValueRowD(L(Str::EditorSize).data(),  st.tpl.size, 100, x, y);
+        if (DrawBtn({x, y, 100, 26}, L(Str::BtnRing).data())) PostRing(id, st.tpl);
+        y += 28;
 
         // Small preview dot using current color
-        DrawCircle(st.panel.x + st.panel.width - 40, st.panel.y + 40, 10, o->color);
+        DrawCircle(st.panel.x + st.panel.width - 40, st.panel.y + 40, 10, row.color);
 
         Rectangle delR = { x, st.panel.y + st.panel.height - 36, 80, 26 };
-        if (DrawBtn(delR, L("btn.delete").c_str())) { o->shouldRemove = true; st.visible = false; st.selected = nullptr; }
+        if (DrawBtn(delR, L(Str::BtnDelete).data())) { PostEdit(id, [](Object* o){ o->shouldRemove() = true; }); st.visible = false; st.selected = NoBody; }
         Rectangle orbitR = {x+90, st.panel.y+st.panel.height-36, 100, 26 };
-        if (DrawBtn(orbitR, L("btn.orbit").c_str())) { st.awaitingOrbitTarget = true; }
+        if (DrawBtn(orbitR, L(Str::BtnOrbit).data())) { st.awaitingOrbitTarget = true; }
     }
 }
 
 inline bool TryPickOrbitTarget(Vector2 mouseScreen){
   State& st = S();
-  if (!st.awaitingOrbitTarget || !st.selected) return false;
-  Object* target = PickObjectAtScreen(mouseScreen);
+  if (!st.awaitingOrbitTarget || st.selected == NoBody) return false;
+  uint64_t targetId = PickObjectAtScreen(mouseScreen);
   st.awaitingOrbitTarget = false;
-  if(!target || target==st.selected) return true;
-  Vector2 r = {st.selected->pos.x - target->pos.x, st.selected->pos.y - target->pos.y};
-  double rlen = std::sqrt((double)r.x*r.x+(double)r.y*r.y);
-  if(rlen<=0 || target->mass<=0) return true;
-  double v = std::sqrt(gravitationalConstant*target->mass/rlen);
-  Vector2 t = {(float)(-r.y/rlen),(float)(r.x/rlen)};
-  st.selected->speed = target->speed + t*(float)v;
+  if(targetId == NoBody || targetId == st.selected) return true;
+  // computed on the simulation thread from the bodies as they are when it runs
+  PostEdit(st.selected, [targetId](Object* o){
+    Object* target = FindBody(targetId);
+    if(!target || target->mass()<=0 || (o->pos().x==target->pos().x && o->pos().y==target->pos().y)) return;
+    o->speed() = SceneGen::orbitVelocity(o->pos(), target->pos(), target->speed(), target->mass());
+  });
   return true;
 }
 } // namespace PhysEditor
@@ -3,145 +3,143 @@
 #include "raylib.h"
 #include <algorithm>
 #include "physics_functions.hpp"
-#include <list>
+#include "physics_bodies.hpp"
+#include "physics_particles.hpp"
+#include "physics_gravity.hpp"
+#include "physics_broadphase.hpp"
+#include "physics_batch.hpp"
 
 class Object{
   public:
   virtual ~Object();
-  Vector2 pos;
-  Vector2 speed;
+  int slot; // index into bodies, kept up to date by BodyStore::removeMarked
   Color color;
-  double frictionFactor;
-  double mass;
   unsigned long long uuid;
-  bool shouldRemove = false;
-  bool gravityAffected = false;
-  bool fixed = false;
-  bool leaveTrail = false;
   Vector2 lastTrailPos;
   double timeAlive = 0;
   Object* lastCollision = nullptr;
-  float elasticity = 0.5; // range: [0;1] || if any at 0, objects are combined at collision; in other cases momentum is transferred back
-  Object(Vector2 pos, Vector2 init_speed, Color color, double mass, double frictionFactor, bool leaveTrail = false){
-    this->pos = pos;
-    this->speed = init_speed;
-    this->frictionFactor = frictionFactor;
+  // Registers itself in bodies, which owns it from then on (see BodyStore::spawn)
+  Object(Shape shape, Vector2 pos, Vector2 init_speed, Color color, double mass, double frictionFactor, bool leaveTrail = false){
+    this->slot = bodies.attach(this, shape);
+    this->pos() = pos;
+    bodies.prevPos[slot] = pos;
+    this->speed() = init_speed;
+    this->frictionFactor() = frictionFactor;
     this->color = color;
-    this->mass = mass;
+    this->mass() = mass;
     this->uuid = getUUID();
-    this->leaveTrail = leaveTrail;
+    this->leaveTrail() = leaveTrail;
     this->lastTrailPos = vector(pos.x,pos.y);
   }
-  virtual void defaultRender(Color col) = 0;
-  void tickTime(){
-    auto ft = GetFrameTime()*timeScale;
-    timeAlive+=ft;
+  // hot fields live in bodies; these return references into it, valid until the next body is created
+  Vector2& pos(){ return bodies.pos[slot]; }
+  Vector2& speed(){ return bodies.speed[slot]; }
+  double& mass(){ return bodies.mass[slot]; }
+  double& frictionFactor(){ return bodies.frictionFactor[slot]; }
+  float& elasticity(){ return bodies.elasticity[slot]; } // range: [0;1] || if any at 0, objects are combined at collision; in other cases momentum is transferred back
+  bool& gravityAffected(){ return bodies.flags[slot].gravityAffected; }
+  bool& fixed(){ return bodies.flags[slot].fixed; }
+  bool& leaveTrail(){ return bodies.flags[slot].leaveTrail; }
+  bool& shouldRemove(){ return bodies.flags[slot].shouldRemove; }
+  bool& simulated(){ return bodies.flags[slot].simulated; }
+  Shape shape(){ return bodies.shape[slot]; } // fixed by the constructor, picks the pair handlers
+  // dt is simulation time (frame time * timeScale in the window, fixed in headless runs)
+  void tickTime(double dt){
+    timeAlive+=dt;
   }
-  virtual void tick(){
-    tickTime();
-    auto ft = GetFrameTime()*timeScale;
-    this->pos+=this->speed*ft;
-    this->speed*=1-frictionFactor*ft;
-    if(this->gravityAffected)this->speed.y+=freeFallAcceleration*ft;
-  };
-  virtual void draw(){
-    defaultRender(color);
+  virtual void tick(double dt){
+    tickTime(dt);
+    auto ft = dt;
+    this->pos()+=this->speed()*ft;
+    this->speed()*=1-frictionFactor()*ft;
+    if(this->gravityAffected())this->speed().y+=freeFallAcceleration*ft;
   };
-  void tickWithAttractionForce();
-  bool tickLifeTime(double maxLifeTimeSeconds){ // returns true if this is the tick when the Object starts being marked as deleted
-    tickTime();
-    if(shouldRemove)return false;
-    if(maxLifeTimeSeconds<=timeAlive)shouldRemove=true;
-    return shouldRemove;
+  bool checkCollision(Object* o);        // overlap test through Collision::overlapTable
+  void resolveCollision(Object* other); // narrowphase for one candidate pair, other must not be massless
+  bool tickLifeTime(double maxLifeTimeSeconds, double dt){ // returns true if this is the tick when the Object starts being marked as deleted
+    tickTime(dt);
+    if(shouldRemove())return false;
+    if(maxLifeTimeSeconds<=timeAlive)shouldRemove()=true;
+    return shouldRemove();
   }
-  virtual bool checkCollision(Object* o, bool desperate=false) = 0; // desperate is the last search flag, to prevent recursion
   virtual double area() = 0;
   virtual void setArea(double a) = 0;
 };
 Object::~Object() {}
-std::list<Object*> objectList;
+
+void BodyStore::removeMarked(){
+  // drop dangling collision links first, while the marked objects are still alive
+  for (size_t j = 0; j < handle.size(); ++j){
+    Object* last = handle[j]->lastCollision;
+    if (last && flags[last->slot].shouldRemove) handle[j]->lastCollision = nullptr;
+  }
+  size_t w = 0;
+  for (size_t r = 0; r < handle.size(); ++r){
+    if (flags[r].shouldRemove){
+      delete handle[r];
+      continue;
+    }
+    if (w != r){
+      pos[w] = pos[r];
+      prevPos[w] = prevPos[r];
+      speed[w] = speed[r];
+      mass[w] = mass[r];
+      radius[w] = radius[r];
+      sides[w] = sides[r];
+      frictionFactor[w] = frictionFactor[r];
+      elasticity[w] = elasticity[r];
+      flags[w] = flags[r];
+      shape[w] = shape[r];
+      handle[w] = handle[r];
+      handle[w]->slot = (int)w;
+    }
+    ++w;
+  }
+  pos.resize(w); prevPos.resize(w); speed.resize(w); mass.resize(w); radius.resize(w); sides.resize(w);
+  frictionFactor.resize(w); elasticity.resize(w); flags.resize(w); shape.resize(w); handle.resize(w);
+}
+void BodyStore::clear(){
+  for (auto* o : handle) delete o;
+  pos.clear(); prevPos.clear(); speed.clear(); mass.clear(); radius.clear(); sides.clear();
+  frictionFactor.clear(); elasticity.clear(); flags.clear(); shape.clear(); handle.clear();
+}
+
 class CircularObject : public Object{
   public:
   virtual ~CircularObject() = default;
-  double radius;
-  CircularObject(Vector2 pos, Vector2 init_speed, Color color, double mass, double radius=1, double frictionFactor=0.02, bool leaveTrail = false): Object(pos,init_speed,color,mass,frictionFactor, leaveTrail){
-    this->radius = radius;
-  }
-  void defaultRender (Color col){
-    DrawCircleV((this->pos-windowPos)/windowScale,this->radius/windowScale*visualScale(),col);
+  double& radius(){ return bodies.radius[slot]; }
+  CircularObject(Vector2 pos, Vector2 init_speed, Color color, double mass, double radius=1, double frictionFactor=0.02, bool leaveTrail = false): Object(Shape::Circle,pos,init_speed,color,mass,frictionFactor, leaveTrail){
+    this->radius() = radius;
   }
   double area(){
-    return radius*radius*M_PI;
+    return radius()*radius()*M_PI;
   }
   void setArea(double a){
-    radius = sqrt(a/M_PI);
-  }
-  bool checkCollision(Object* o, bool desperate=false){
-    auto* c = dynamic_cast<CircularObject*>(o);
-    if (c) {
-      return distance(pos,c->pos)<radius+c->radius;
-    }
-    if(!desperate) return o->checkCollision(this,true);
-    return false;
+    radius() = sqrt(a/M_PI);
   }
   void trail();
 };
-class Particle : public CircularObject{
-  public:
-  ~Particle() = default;
-  double fadeSeconds;
-  Particle(Vector2 pos, Vector2 init_speed, Color color, double radius=1, double fadeSeconds=3, double frictionFactor=0.02) : CircularObject(pos,init_speed,color,0,radius,frictionFactor){
-    this->fadeSeconds = fadeSeconds;
-  }
-  Color calculateColor(){
-    Color n(this->color);
-    n.a = 255-(char)(255*(timeAlive/fadeSeconds));
-    return n;
-  }
-  void draw() override{
-    if(shouldRemove)return;
-    defaultRender(this->calculateColor());
-  }
-  void tick() override{
-    CircularObject::tick();
-    CircularObject::tickLifeTime(fadeSeconds);
-  }
-};
-class TrailParticle : public CircularObject {
-  public:
-  ~TrailParticle() = default;
-  TrailParticle(Vector2 pos, Vector2 init_speed, Color color, double radius=1,double frictionFactor=0.02) : CircularObject(pos,init_speed,color,0,radius,frictionFactor){
-  }
-  Color calculateColor(){
-    Color n(this->color);
-    n.a = 255-(char)(255*(timeAlive/trailLifetime));
-    return n;
-  }
-  void draw() override{
-    if(shouldRemove)return;
-    defaultRender(this->calculateColor());
-  }
-  void tick() override{
-    tickTime();
-    if(timeAlive>trailLifetime) shouldRemove=true;
-  }
-};
-
-void explosion(Vector2 pos,Color color,double maxSize,double speed=1,int maxParticles=30,int minParticles=0){
-  for(int _=0;_<minParticles+randFloat()*(maxParticles-minParticles);_++){
-    objectList.push_back(new Particle(pos,vector(randNegFloat(),randNegFloat())*speed,color,maxSize*randFloat()));
+// Debris lifetime. The old per-object particles aged twice per tick (tick and tickLifeTime) and so
+// faded over half their nominal 3 s; the pool ages once, so it gets the 1.5 s they actually lasted.
+const double explosionFadeSeconds = 1.5;
+// Debris draws from the emitter's own stream (emitterStream()), so it doesn't depend on how many
+// numbers other explosions drew before it.
+void explosion(Rng::Stream rng,Vector2 pos,Color color,double maxSize,double speed=1,int maxParticles=30,int minParticles=0){
+  for(int _=0;_<minParticles+randFloat(rng)*(maxParticles-minParticles);_++){
+    particles.emit(pos,vector(randNegFloat(rng),randNegFloat(rng))*speed,color,maxSize*randFloat(rng),explosionFadeSeconds);
   }
 }
-void explosion(Vector2 pos,Color color,double maxSize,Vector2 speed,int maxParticles=30,int minParticles=0){
-  for(int _=0;_<minParticles+randFloat()*(maxParticles-minParticles);_++){
-    objectList.push_back(new Particle(pos,vector(randNegFloat(),randNegFloat())*speed,color,maxSize*randFloat()));
+void explosion(Rng::Stream rng,Vector2 pos,Color color,double maxSize,Vector2 speed,int maxParticles=30,int minParticles=0){
+  for(int _=0;_<minParticles+randFloat(rng)*(maxParticles-minParticles);_++){
+    particles.emit(pos,vector(randNegFloat(rng),randNegFloat(rng))*speed,color,maxSize*randFloat(rng),explosionFadeSeconds);
   }
 }
 
 void CircularObject::trail(){
-  if (distance(pos,lastTrailPos)>2*radius){
-    objectList.push_back(new TrailParticle(lastTrailPos,vector(),color,radius*0.1));
-    lastTrailPos.x=pos.x;lastTrailPos.y=pos.y;
+  if (distance(pos(),lastTrailPos)>2*radius()){
+    Vector2 p = pos();
+    particles.emitTrail(lastTrailPos,color,radius()*0.1);
+    lastTrailPos.x=p.x;lastTrailPos.y=p.y;
   }
 }
 
@@ -149,11 +147,13 @@ void CircularObject::trail(){
 class PhysicsCircularObject : public CircularObject {
   public:
   PhysicsCircularObject(Vector2 pos, Vector2 init_speed, Color color, double mass, double radius = 1, double frictionFactor = 0.02, bool leaveTrail = false)
-    : CircularObject(pos, init_speed, color, mass, radius, frictionFactor, leaveTrail) {}
-  void tick() override{
-    tickWithAttractionForce();
-    if(leaveTrail)trail();
-    tickTime();
+    : CircularObject(pos, init_speed, color, mass, radius, frictionFactor, leaveTrail) {
+    simulated() = true;
+  }
+  // motion is integrated by World::step; this only handles per-frame effects
+  void tick(double dt) override{
+    if(leaveTrail())trail();
+    tickTime(dt);
   }
 };
 
@@ -161,11 +161,22 @@ class Rocket : public PhysicsCircularObject{
   public:
   ~Rocket() = default;
   double fireworkAccelerationFactor = 0.2;
+  // Exhaust particles per simulated second, what one per rendered frame used to give. Emitting at a
+  // rate keeps the exhaust the same however often bodies are ticked (1000 Hz simulation thread,
+  // headless --dt).
+  double exhaustRate = 60;
+  double exhaustTime = 0; // simulated time since the last exhaust particle
+  uint64_t exhaustEmitted = 0; // keys each particle's stream, as one tick may emit several
   Rocket(Vector2 pos, Vector2 init_speed, Color color, double mass, double radius=1, double frictionFactor=0.02) : PhysicsCircularObject(pos,init_speed,color,mass,radius,frictionFactor){}
-  void tick(){
-    PhysicsCircularObject::tick();
-    this->speed+=speed*fireworkAccelerationFactor*GetFrameTime()*timeScale;
-    explosion(pos,color,radius*0.3,vector(10,10),1);
+  void tick(double dt){
+    PhysicsCircularObject::tick(dt);
+    this->speed()+=speed()*fireworkAccelerationFactor*dt;
+    exhaustTime+=std::fabs(dt);
+    while(exhaustTime>=1/exhaustRate){
+      exhaustTime-=1/exhaustRate;
+      // ~n is never the burst's 1 or a collision's uuid + 2
+      explosion(emitterStream(uuid,~exhaustEmitted++),pos(),color,radius()*0.3,vector(10,10),1,1);
+    }
   };
 };
 class Firework : public Rocket{
@@ -175,390 +186,347 @@ class Firework : public Rocket{
   Firework(Vector2 pos, Vector2 init_speed, Color color, double mass, double radius=1, double frictionFactor=0.02, double lifeTime=10) : Rocket(pos,init_speed,color,mass,radius,frictionFactor){
     this->lifeTime = lifeTime;
   }
-  void tick(){
-    Rocket::tick();
-    if(tickLifeTime(lifeTime)) explosion(pos,color,radius*0.7,50,300,100);
+  void tick(double dt){
+    Rocket::tick(dt);
+    if(tickLifeTime(lifeTime, dt)) explosion(emitterStream(uuid, 1),pos(),color,radius()*0.7,50,300,100);
   }
 };
 
 class RectangularObject : public Object{
   public:
   virtual ~RectangularObject() = default;
-  Vector2 sides;
-  RectangularObject(Vector2 pos, Vector2 init_speed, Color color, double mass, Vector2 sides, double frictionFactor=0.02): Object(pos,init_speed,color,mass,frictionFactor){
-    this->sides = sides;
-  }
-  void defaultRender (Color col){
-    DrawRectangleRec(rectOnScreen(), color);
+  Vector2& sides(){ return bodies.sides[slot]; }
+  RectangularObject(Vector2 pos, Vector2 init_speed, Color color, double mass, Vector2 sides, double frictionFactor=0.02): Object(Shape::Rectangle,pos,init_speed,color,mass,frictionFactor){
+    this->sides() = sides;
   }
   double area(){
-    return sides.x*sides.y;
+    return sides().x*sides().y;
   }
   void setArea(double a){
-    sides*=a/area();
+    sides()*=a/area();
   }
   Rectangle rect(){
     Rectangle r;
-    r.width = sides.x;
-    r.height = sides.y;
-    r.x = pos.x-r.width/2;
-    r.y = pos.y-r.height/2;
+    r.width = sides().x;
+    r.height = sides().y;
+    r.x = pos().x-r.width/2;
+    r.y = pos().y-r.height/2;
     return r;
   }
-  Rectangle rectOnScreen(){
-    Rectangle r;
-    r.width = sides.x/windowScale;
-    r.height = sides.y/windowScale;
-    r.x = (pos.x-windowPos.x)/windowScale*visualScale()-r.width/2;
-    r.y = (pos.y-windowPos.y)/windowScale*visualScale()-r.height/2;
-    return r;
-  }
-  bool checkCollision(Object* o, bool desperate=false){ 
-    auto* c = dynamic_cast<RectangularObject*>(o);
-    if (c) {
-      return CheckCollisionRecs(rect(), c->rect());
-    }
-    auto* r = dynamic_cast<CircularObject*>(o);
-    if (r) {
-      return CheckCollisionCircleRec(r->pos, r->radius, rect());
-    }
-    if(!desperate) return o->checkCollision(this,true);
-    return false;
-  }
 };
 class PhysicsRectangularObject : public RectangularObject {
   public:
   PhysicsRectangularObject(Vector2 pos, Vector2 init_speed, Color color, double mass, Vector2 sides, double frictionFactor = 0.02)
-    : RectangularObject(pos, init_speed, color, mass, sides, frictionFactor) {}
-  void tick() override{
-    tickWithAttractionForce();
+    : RectangularObject(pos, init_speed, color, mass, sides, frictionFactor) {
+    simulated() = true;
   }
+  void tick(double) override{} // integrated by World::step
 };
 
-void Object::tickWithAttractionForce() {
-  if (lastCollision && !checkCollision(lastCollision)) lastCollision = nullptr;
-
-  // time stepping (substep to avoid tunneling/creep)
-  const double ft = GetFrameTime() * timeScale;
-  const double maxDt = 1.0 / 240.0;                 // ~4.17 ms substeps
-  int steps = (int)ceil(ft / maxDt);
-  if (steps < 1) steps = 1;
-  const double dt = ft / steps;
-
-  for (int s = 0; s < steps; ++s) {
-    Vector2 F = vector(0, 0);
-    auto handleCircleRect = [&](CircularObject* circle, Object* circleObj,
-                                RectangularObject* rect, Object* rectObj)
-    {
-      if (!circle || !rect) return;
-
-      Rectangle r = rect->rect();
-      float cx = circle->pos.x;
-      float cy = circle->pos.y;
-      float cr = (float)circle->radius;
-
-      // Expand rectangle by circle radius (Minkowski sum)
-      float ex = r.x - cr;
-      float ey = r.y - cr;
-      float ew = r.width  + 2.0f * cr;
-      float eh = r.height + 2.0f * cr;
-
-      // If center not inside expanded rect, nothing to do
-      if (cx < ex || cx > ex + ew || cy < ey || cy > ey + eh) return;
-
-      // Distances to each side of expanded rect
-      float distLeft   = cx - ex;
-      float distRight  = (ex + ew) - cx;
-      float distTop    = cy - ey;
-      float distBottom = (ey + eh) - cy;
-
-      // Minimal translation to push circle center out
-      float pen = distLeft;
-      Vector2 n = { -1.0f, 0.0f }; // default: push left
-
-      if (distRight < pen) {
-        pen = distRight;
-        n = { +1.0f, 0.0f };
-      }
-      if (distTop < pen) {
-        pen = distTop;
-        n = { 0.0f, -1.0f };
-      }
-      if (distBottom < pen) {
-        pen = distBottom;
-        n = { 0.0f, +1.0f };
-      }
+// ---------------- pair handlers ----------------
+// The shape tag guarantees the concrete class, so the handlers static_cast instead of probing with RTTI.
+namespace Collision {
 
-      // Full positional correction
-      if (pen > 0.0f) {
-        circle->pos += n * pen;
-      }
+using OverlapFn = bool (*)(Object* a, Object* b);
+using CollideFn = void (*)(Object* a, Object* b);
 
-      float vN = Vector2DotProduct(circleObj->speed, n);
-      if (vN < 0.0f) {  // only if moving into the rect
-        float e = std::clamp((float)circleObj->elasticity, 0.0f, 1.0f);
-        float new_vN = -vN * e;
-        circleObj->speed = circleObj->speed + n * (new_vN - vN);
-      }
+inline CircularObject* asCircle(Object* o){ return static_cast<CircularObject*>(o); }
+inline RectangularObject* asRect(Object* o){ return static_cast<RectangularObject*>(o); }
 
-      circleObj->lastCollision = rectObj;
-      rectObj->lastCollision   = circleObj;
-    };
-    for (auto i = objectList.begin(); i != objectList.end(); ) {
-      if ((*i)->mass == 0 || uuid == (*i)->uuid) { ++i; continue; }
-
-      if (checkCollision(*i)) {
-        auto selfC  = dynamic_cast<CircularObject*>(this);
-        auto otherC = dynamic_cast<CircularObject*>(*i);
-        auto selfR  = dynamic_cast<RectangularObject*>(this);
-        auto otherR = dynamic_cast<RectangularObject*>(*i);
-
-        if (selfC && otherC) {
-          double dx = otherC->pos.x - selfC->pos.x;
-          double dy = otherC->pos.y - selfC->pos.y;
-          double d  = std::sqrt(dx*dx + dy*dy);
-          double target = selfC->radius + otherC->radius;
-          double pen = target - d;
-          if (pen > 0.0 && d > 0.0) {
-            const double slop = 0.1;      // allow tiny overlap
-            const double percent = 0.8;   // resolve 80% each frame
-            double corr = std::max(0.0, pen - slop) * percent;
-
-            Vector2 n = { (float)(dx / d), (float)(dy / d) };
-            double im1 = (mass > 0.0)       ? 1.0 / mass       : 0.0;
-            double im2 = ((*i)->mass > 0.0) ? 1.0 / (*i)->mass : 0.0;
-
-            // Fixed objects don't move under position correction
-            if (fixed)         im1 = 0.0;
-            if ((*i)->fixed)   im2 = 0.0;
-
-            double sum = im1 + im2; 
-            if (sum == 0.0) sum = 1.0;
-            selfC->pos  -= n * (float)(corr * (im1 / sum));
-            otherC->pos += n * (float)(corr * (im2 / sum));
-          }
+bool overlapCircles(Object* a, Object* b){
+  return distance(a->pos(), b->pos()) < asCircle(a)->radius() + asCircle(b)->radius();
+}
+bool overlapCircleRect(Object* circle, Object* rect){
+  return CheckCollisionCircleRec(circle->pos(), asCircle(circle)->radius(), asRect(rect)->rect());
+}
+bool overlapRectCircle(Object* rect, Object* circle){
+  return overlapCircleRect(circle, rect);
+}
+bool overlapRects(Object* a, Object* b){
+  return CheckCollisionRecs(asRect(a)->rect(), asRect(b)->rect());
+}
 
-          // Elastic vs merge
-          if (elasticity != 0 && (*i)->elasticity != 0) {
-            Vector2 n = Vector2Normalize(otherC->pos - selfC->pos);
-            float v1 = Vector2DotProduct(speed, n);
-            float v2 = Vector2DotProduct((*i)->speed, n);
-            bool approaching = (v1 - v2) > 0.0f;
-
-            if (approaching) {
-              float avgE = std::clamp((elasticity + (*i)->elasticity) * 0.5f, 0.0f, 1.0f);
-              float new_v1 = v1;
-              float new_v2 = v2;
-
-              if (fixed && !(*i)->fixed) {
-                  new_v1 = 0.0f;
-                  new_v2 = -v2 * avgE;
-              } else if (!fixed && (*i)->fixed) {
-                  new_v1 = -v1 * avgE;
-                  new_v2 = 0.0f;
-              } else {
-                  new_v1 = ((float)(mass - (*i)->mass) * v1 + 2.0f * (float)(*i)->mass * v2) / (float)(mass + (*i)->mass);
-                  new_v2 = (2.0f * (float)mass * v1 + (float)((*i)->mass - mass) * v2) / (float)(mass + (*i)->mass);
-                  new_v1 *= avgE;
-                  new_v2 *= avgE;
-              }
-
-              if (!fixed)
-                  speed = speed - n * v1 + n * new_v1;
-              if (!(*i)->fixed)
-                  (*i)->speed = (*i)->speed - n * v2 + n * new_v2;
-
-              if (lastCollision != *i && distance(speed) + distance((*i)->speed) > 20) {
-                  // approximate contact point between spheres
-                  Vector2 hitPos;
-                  double totalR = selfC->radius + otherC->radius;
-                  if (totalR > 0.0) {
-                      float t = (float)(selfC->radius / totalR);
-                      hitPos = selfC->pos * t + otherC->pos * (1.0f - t);
-                  } else {
-                      hitPos = (selfC->pos + otherC->pos) * 0.5f;
-                  }
-
-                  auto otherArea = otherC->area();
-                  explosion(hitPos,
-                            color,
-                            std::sqrt(otherArea) * 0.2,
-                            distance((*i)->speed) * 1.5,
-                            (int)std::sqrt(distance(speed) + distance((*i)->speed)));
-              }
-            }
-
-            (*i)->lastCollision = this;
-            lastCollision = *i;
-            ++i;
-            continue;
+void collideCircles(Object* self, Object* other){
+  CircularObject* selfC = asCircle(self);
+  CircularObject* otherC = asCircle(other);
+  double dx = otherC->pos().x - selfC->pos().x;
+  double dy = otherC->pos().y - selfC->pos().y;
+  double d  = std::sqrt(dx*dx + dy*dy);
+  double target = selfC->radius() + otherC->radius();
+  double pen = target - d;
+  if (pen > 0.0 && d > 0.0) {
+    const double slop = 0.1;      // allow tiny overlap
+    const double percent = 0.8;   // resolve 80% each frame
+    double corr = std::max(0.0, pen - slop) * percent;
+
+    Vector2 n = { (float)(dx / d), (float)(dy / d) };
+    double im1 = (self->mass() > 0.0)  ? 1.0 / self->mass()  : 0.0;
+    double im2 = (other->mass() > 0.0) ? 1.0 / other->mass() : 0.0;
+
+    // Fixed objects don't move under position correction
+    if (self->fixed())    im1 = 0.0;
+    if (other->fixed())   im2 = 0.0;
+
+    double sum = im1 + im2; 
+    if (sum == 0.0) sum = 1.0;
+    selfC->pos()  -= n * (float)(corr * (im1 / sum));
+    otherC->pos() += n * (float)(corr * (im2 / sum));
+  }
+
+  // Elastic vs merge
+  if (self->elasticity() != 0 && other->elasticity() != 0) {
+    Vector2 n = Vector2Normalize(otherC->pos() - selfC->pos());
+    float v1 = Vector2DotProduct(self->speed(), n);
+    float v2 = Vector2DotProduct(other->speed(), n);
+    bool approaching = (v1 - v2) > 0.0f;
+
+    if (approaching) {
+      float avgE = std::clamp((self->elasticity() + other->elasticity()) * 0.5f, 0.0f, 1.0f);
+      float new_v1 = v1;
+      float new_v2 = v2;
+
+      if (self->fixed() && !other->fixed()) {
+          new_v1 = 0.0f;
+          new_v2 = -v2 * avgE;
+      } else if (!self->fixed() && other->fixed()) {
+          new_v1 = -v1 * avgE;
+          new_v2 = 0.0f;
+      } else {
+          new_v1 = ((float)(self->mass() - other->mass()) * v1 + 2.0f * (float)other->mass() * v2) / (float)(self->mass() + other->mass());
+          new_v2 = (2.0f * (float)self->mass() * v1 + (float)(other->mass() - self->mass()) * v2) / (float)(self->mass() + other->mass());
+          new_v1 *= avgE;
+          new_v2 *= avgE;
+      }
+
+      if (!self->fixed())
+          self->speed() = self->speed() - n * v1 + n * new_v1;
+      if (!other->fixed())
+          other->speed() = other->speed() - n * v2 + n * new_v2;
+
+      if (self->lastCollision != other && distance(self->speed()) + distance(other->speed()) > 20) {
+          // approximate contact point between spheres
+          Vector2 hitPos;
+          double totalR = selfC->radius() + otherC->radius();
+          if (totalR > 0.0) {
+              float t = (float)(selfC->radius() / totalR);
+              hitPos = selfC->pos() * t + otherC->pos() * (1.0f - t);
           } else {
-            // Merge branch (any elasticity == 0)
-            auto ownArea   = selfC->area();
-            auto otherArea = otherC->area();
-
-            if (otherArea > ownArea) {
-              auto oldPos = pos;
-              pos = (*i)->pos;
-              (*i)->pos = oldPos; // for correct particle spawning
-            }
-
-            explosion((*i)->pos, (*i)->color, std::sqrt(otherArea) * 0.5, distance((*i)->speed) * 0.5);
-            selfC->setArea(ownArea + otherArea);
-
-            double areaSum = ownArea + otherArea;
-            ownArea   /= areaSum;
-            otherArea /= areaSum;
-
-            double sumMass = mass + (*i)->mass;
-            speed = (speed * mass + (*i)->speed * (*i)->mass) / sumMass;
-            mass  = sumMass;
-
-            color.r = (unsigned char)std::clamp(color.r * ownArea + (*i)->color.r * otherArea, 0.0, 255.0);
-            color.g = (unsigned char)std::clamp(color.g * ownArea + (*i)->color.g * otherArea, 0.0, 255.0);
-            color.b = (unsigned char)std::clamp(color.b * ownArea + (*i)->color.b * otherArea, 0.0, 255.0);
-
-            delete *i;
-            i = objectList.erase(i);
-            continue;
-          }
-        } 
-        else if (selfC && otherR) {
-          // circle = this, rect = *i
-          handleCircleRect(selfC, this, otherR, *i);
-          ++i;
-          continue;
-        } else if (selfR && otherC) {
-          // circle = *i, rect = this
-          handleCircleRect(otherC, *i, selfR, this);
-          ++i;
-          continue;
-        } else if (selfR && otherR) {
-          RectangularObject* A = selfR;
-          RectangularObject* B = otherR;
-
-          float ax = A->pos.x;
-          float ay = A->pos.y;
-          float bx = B->pos.x;
-          float by = B->pos.y;
-
-          float ahx = A->sides.x * 0.5f;
-          float ahy = A->sides.y * 0.5f;
-          float bhx = B->sides.x * 0.5f;
-          float bhy = B->sides.y * 0.5f;
-
-          // delta between centers
-          float dx = bx - ax;
-          float dy = by - ay;
-
-          float px = (ahx + bhx) - std::fabs(dx);
-          float py = (ahy + bhy) - std::fabs(dy);
-
-          if (px > 0.0f && py > 0.0f) {
-              Vector2 n;
-              float  pen;
-
-              if (px < py) {
-                  pen = px;
-                  n = { dx >= 0.0f ? 1.0f : -1.0f, 0.0f };
-              } else {
-                  pen = py;
-                  n = { 0.0f, dy >= 0.0f ? 1.0f : -1.0f };
-              }
-
-              double imA = (mass       > 0.0) ? 1.0 / mass       : 0.0;
-              double imB = ((*i)->mass > 0.0) ? 1.0 / (*i)->mass : 0.0;
-              double sum = imA + imB;
-              if (sum == 0.0) sum = 1.0;
-
-              A->pos -= n * (float)(pen * (imA / sum));
-              B->pos += n * (float)(pen * (imB / sum));
-
-              float vA = Vector2DotProduct(speed,        n);
-              float vB = Vector2DotProduct((*i)->speed,  n);
-
-              if (vA - vB > 0.0f) {
-                  float e = std::clamp(
-                      (float)((elasticity + (*i)->elasticity) * 0.5),
-                      0.0f, 1.0f
-                  );
-
-                  double mA = mass;
-                  double mB = (*i)->mass;
-                  if (mA + mB <= 0.0) {
-                      float new_vA = -vA * e;
-                      speed = speed - n * vA + n * new_vA;
-                  } else {
-                      float new_vA = ((float)(mA - mB) * vA + 2.0f * (float)mB * vB) / (float)(mA + mB);
-                      float new_vB = (2.0f * (float)mA * vA + (float)(mB - mA) * vB) / (float)(mA + mB);
-                      new_vA *= e;
-                      new_vB *= e;
-
-                      speed        = speed        - n * vA + n * new_vA;
-                      (*i)->speed  = (*i)->speed  - n * vB + n * new_vB;
-                  }
-              }
+              hitPos = (selfC->pos() + otherC->pos()) * 0.5f;
           }
 
-          (*i)->lastCollision = this;
-          lastCollision       = *i;
-          ++i;
-          continue;
-        } else {
-          (*i)->lastCollision = this;
-          lastCollision       = *i;
-          ++i;
-          continue;
-        }
+          auto otherArea = otherC->area();
+          explosion(emitterStream(self->uuid, other->uuid + 2),
+                    hitPos,
+                    self->color,
+                    std::sqrt(otherArea) * 0.2,
+                    distance(other->speed()) * 1.5,
+                    (int)std::sqrt(distance(self->speed()) + distance(other->speed())));
       }
+    }
 
-      double dx = (*i)->pos.x - pos.x;
-      double dy = (*i)->pos.y - pos.y;
-      const double soft2 = 1e-4;                 // tune in engine units^2
-      double r2 = dx*dx + dy*dy + soft2;
-      double invR = 1.0 / std::sqrt(r2);
-      double scalarF = gravitationalConstant * mass * (*i)->mass / r2;
-      F += vector(dx * invR, dy * invR) * scalarF;
-
-      ++i;
-    } // objects loop
-
-    // friction as exponential decay for stability
-    if (!fixed) {
-      speed *= (float)std::exp(-frictionFactor * dt);
-      if (gravityAffected) speed.y += (float)(freeFallAcceleration * dt);
-      if (mass > 0.0) {
-        Vector2 a = F / mass;
-        speed += a * (float)dt;
-      }
-      pos += speed * (float)dt;
+    other->lastCollision = self;
+    self->lastCollision = other;
+  } else {
+    // Merge branch (any elasticity == 0)
+    auto ownArea   = selfC->area();
+    auto otherArea = otherC->area();
+
+    if (otherArea > ownArea) {
+      auto oldPos = self->pos();
+      self->pos() = other->pos();
+      other->pos() = oldPos; // for correct particle spawning
     }
 
-    // hygiene
-    if (!std::isfinite(speed.x)) speed.x = 0;
-    if (!std::isfinite(speed.y)) speed.y = 0;
-    if (!std::isfinite(pos.x))   pos.x   = 0;
-    if (!std::isfinite(pos.y))   pos.y   = 0;
-    const double VMAX = 1e7;
-    double vlen = distance(speed);
-    if (vlen > VMAX) speed *= (float)(VMAX / vlen);
+    explosion(emitterStream(self->uuid, other->uuid + 2), other->pos(), other->color, std::sqrt(otherArea) * 0.5, distance(other->speed()) * 0.5);
+    selfC->setArea(ownArea + otherArea);
+
+    double areaSum = ownArea + otherArea;
+    ownArea   /= areaSum;
+    otherArea /= areaSum;
+
+    double sumMass = self->mass() + other->mass();
+    self->speed() = (self->speed() * self->mass() + other->speed() * other->mass()) / sumMass;
+    self->mass()  = sumMass;
+
+    Color& color = self->color;
+    color.r = (unsigned char)std::clamp(color.r * ownArea + other->color.r * otherArea, 0.0, 255.0);
+    color.g = (unsigned char)std::clamp(color.g * ownArea + other->color.g * otherArea, 0.0, 255.0);
+    color.b = (unsigned char)std::clamp(color.b * ownArea + other->color.b * otherArea, 0.0, 255.0);
+
+    other->shouldRemove() = true; // later pairs skip it, BodyStore::removeMarked deletes it
+    other->mass() = 0;
   }
 }
 
+void collideCircleRect(Object* circleObj, Object* rectObj){
+  CircularObject* circle = asCircle(circleObj);
+  Rectangle r = asRect(rectObj)->rect();
+  float cx = circle->pos().x;
+  float cy = circle->pos().y;
+  float cr = (float)circle->radius();
+
+  // Expand rectangle by circle radius (Minkowski sum)
+  float ex = r.x - cr;
+  float ey = r.y - cr;
+  float ew = r.width  + 2.0f * cr;
+  float eh = r.height + 2.0f * cr;
+
+  // If center not inside expanded rect, nothing to do
+  if (cx < ex || cx > ex + ew || cy < ey || cy > ey + eh) return;
+
+  // Distances to each side of expanded rect
+  float distLeft   = cx - ex;
+  float distRight  = (ex + ew) - cx;
+  float distTop    = cy - ey;
+  float distBottom = (ey + eh) - cy;
+
+  // Minimal translation to push circle center out
+  float pen = distLeft;
+  Vector2 n = { -1.0f, 0.0f }; // default: push left
+
+  if (distRight < pen) {
+    pen = distRight;
+    n = { +1.0f, 0.0f };
+  }
+  if (distTop < pen) {
+    pen = distTop;
+    n = { 0.0f, -1.0f };
+  }
+  if (distBottom < pen) {
+    pen = distBottom;
+    n = { 0.0f, +1.0f };
+  }
+
+  // Full positional correction
+  if (pen > 0.0f) {
+    circle->pos() += n * pen;
+  }
+
+  float vN = Vector2DotProduct(circleObj->speed(), n);
+  if (vN < 0.0f) {  // only if moving into the rect
+    float e = std::clamp((float)circleObj->elasticity(), 0.0f, 1.0f);
+    float new_vN = -vN * e;
+    circleObj->speed() = circleObj->speed() + n * (new_vN - vN);
+  }
+
+  circleObj->lastCollision = rectObj;
+  rectObj->lastCollision   = circleObj;
+}
+void collideRectCircle(Object* rect, Object* circle){
+  collideCircleRect(circle, rect);
+}
+
+void collideRects(Object* self, Object* other){
+  RectangularObject* A = asRect(self);
+  RectangularObject* B = asRect(other);
+
+  float ax = A->pos().x;
+  float ay = A->pos().y;
+  float bx = B->pos().x;
+  float by = B->pos().y;
+
+  float ahx = A->sides().x * 0.5f;
+  float ahy = A->sides().y * 0.5f;
+  float bhx = B->sides().x * 0.5f;
+  float bhy = B->sides().y * 0.5f;
+
+  // delta between centers
+  float dx = bx - ax;
+  float dy = by - ay;
+
+  float px = (ahx + bhx) - std::fabs(dx);
+  float py = (ahy + bhy) - std::fabs(dy);
+
+  if (px > 0.0f && py > 0.0f) {
+      Vector2 n;
+      float  pen;
+
+      if (px < py) {
+          pen = px;
+          n = { dx >= 0.0f ? 1.0f : -1.0f, 0.0f };
+      } else {
+          pen = py;
+          n = { 0.0f, dy >= 0.0f ? 1.0f : -1.0f };
+      }
+
+      double imA = (self->mass()  > 0.0) ? 1.0 / self->mass()  : 0.0;
+      double imB = (other->mass() > 0.0) ? 1.0 / other->mass() : 0.0;
+      double sum = imA + imB;
+      if (sum == 0.0) sum = 1.0;
+
+      A->pos() -= n * (float)(pen * (imA / sum));
+      B->pos() += n * (float)(pen * (imB / sum));
+
+      float vA = Vector2DotProduct(self->speed(),  n);
+      float vB = Vector2DotProduct(other->speed(), n);
+
+      if (vA - vB > 0.0f) {
+          float e = std::clamp(
+              (float)((self->elasticity() + other->elasticity()) * 0.5),
+              0.0f, 1.0f
+          );
+
+          double mA = self->mass();
+          double mB = other->mass();
+          if (mA + mB <= 0.0) {
+              float new_vA = -vA * e;
+              self->speed() = self->speed() - n * vA + n * new_vA;
+          } else {
+              float new_vA = ((float)(mA - mB) * vA + 2.0f * (float)mB * vB) / (float)(mA + mB);
+              float new_vB = (2.0f * (float)mA * vA + (float)(mB - mA) * vB) / (float)(mA + mB);
+              new_vA *= e;
+              new_vB *= e;
+
+              self->speed()  = self->speed()  - n * vA + n * new_vA;
+              other->speed() = other->speed() - n * vB + n * new_vB;
+          }
+      }
+  }
+
+  other->lastCollision = self;
+  self->lastCollision = other;
+}
+
+// [shape of a][shape of b]; a new shape fills one row and one column
+OverlapFn overlapTable[(int)Shape::Count][(int)Shape::Count] = {
+  /* Circle    */ {overlapCircles,    overlapCircleRect},
+  /* Rectangle */ {overlapRectCircle, overlapRects},
+};
+CollideFn collideTable[(int)Shape::Count][(int)Shape::Count] = {
+  /* Circle    */ {collideCircles,    collideCircleRect},
+  /* Rectangle */ {collideRectCircle, collideRects},
+};
+
+} // namespace Collision
+
+bool Object::checkCollision(Object* o){
+  return Collision::overlapTable[(int)shape()][(int)o->shape()](this, o);
+}
+
+void Object::resolveCollision(Object* other){
+  if (checkCollision(other)) Collision::collideTable[(int)shape()][(int)other->shape()](this, other);
+}
+
 struct Star{
   Vector2 pos;
   float size;
   Color color;
 };
 std::vector<Star> gStars;
+// runs on the render thread, so it draws from its own generator rather than the world's
 void StarsInit() {
+    static Rng::Stream starGen(rd());
     gStars.clear();
     for (int i = 0; i < 500; i++) {
         Star s;
-        s.pos = vector(randFloat() * screenWidth, randFloat() * screenHeight);
-        s.size = 1 + randFloat(); // 1–3 pixels
-        unsigned char brightness = 200 + (unsigned char)(55 * randFloat());
+        s.pos = vector(starGen.unit() * screenWidth, starGen.unit() * screenHeight);
+        s.size = 1 + starGen.unit(); // 1–3 pixels
+        unsigned char brightness = 200 + (unsigned char)(55 * starGen.unit());
         s.color = {brightness, brightness, brightness, 255};
         gStars.push_back(s);
     }
 }
+void DrawStars() {
+    for (const auto& s : gStars) shapeBatch.circle(s.pos, s.size, s.color);
+    shapeBatch.end();
+}
@@ -0,0 +1,373 @@
+#pragma once
+#include "physics_variables.hpp"
+#include "physics_threads.hpp"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+
+// Fast multipole method for the same softened field as Gravity::Tree: sum of M*d/|d|^3 with
+// |d|^2 = dx^2 + dy^2 + gravitySoftening2, which is the gradient of the potential sum M/|d|. That potential
+// is the 3D 1/r restricted to the plane rather than the 2D log kernel, so complex expansions don't apply;
+// the expansions are Cartesian Taylor series of total degree p (Dehnen's falcON scheme), exact for the
+// softened kernel too. Cells of up to LeafSize bodies hold multipole moments about their centre of mass;
+// a dual-tree walk turns well-separated cell pairs ((r_a + r_b) < theta * distance) into multipole-to-local
+// translations and near leaf pairs into direct sums, then local expansions are pushed down to the bodies.
+// Cost is O(N) for fixed p and theta; error falls roughly as theta^(p+1).
+namespace Fmm {
+
+const int MaxOrder = 12;
+const int MaxCoefficients = (MaxOrder + 1) * (MaxOrder + 2) / 2;
+
+// coefficients of total degree <= p, ordered by degree, then by the power of y
+inline int index(int a, int b){ int n = a + b; return n * (n + 1) / 2 + b; }
+inline int coefficients(int p){ return (p + 1) * (p + 2) / 2; }
+
+// out[k] = d^k / k!
+inline void scaledPowers(double d, int p, double* out){
+  out[0] = 1;
+  for (int k = 1; k <= p; ++k) out[k] = out[k - 1] * d / k;
+}
+
+struct Cell {
+  double cx, cy, half;  // square used for splitting
+  double zx, zy;        // expansion centre (centre of mass)
+  double r;             // bound on the body distance from the expansion centre
+  double m;
+  int begin, end;       // body range in the sorted arrays
+  int child[4];         // -1 where the quadrant is empty
+  bool leaf;
+};
+
+class Solver {
+  public:
+  static const int LeafSize = 16;
+  static const int MaxDepth = 48;
+  // target subtrees handed to the pool; fixed rather than per thread, since where the dual traversal
+  // starts changes its interaction lists and so the rounding, and runs must not depend on --threads
+  static const size_t Tasks = 256;
+
+  void clear(){
+    px.clear(); py.clear(); pm.clear(); pid.clear();
+  }
+  void add(double x, double y, double m, int id){
+    px.push_back(x); py.push_back(y); pm.push_back(m); pid.push_back(id);
+  }
+  size_t size() const { return px.size(); }
+  size_t cellCount() const { return cells.size(); }
+
+  // body k in add() order
+  int id(size_t k) const { return pid[k]; }
+  double fieldX(size_t k) const { return fx[k]; }
+  double fieldY(size_t k) const { return fy[k]; }
+
+  // Field of all bodies at every body (itself excluded), expansions of degree `order` (1..MaxOrder)
+  void solve(int order, double theta, ThreadPool& pool){
+    p = std::clamp(order, 1, MaxOrder);
+    nc = coefficients(p);
+    theta2 = theta * theta;
+    // below this many body pairs a direct sum is cheaper than one translation
+    directPairs = (size_t)nc * nc / 4;
+    const size_t n = px.size();
+    fx.assign(n, 0.0);
+    fy.assign(n, 0.0);
+    cells.clear();
+    if (n == 0) return;
+    build();
+    multipole.assign(cells.size() * nc, 0.0);
+    local.assign(cells.size() * nc, 0.0);
+    sfx.assign(n, 0.0);
+    sfy.assign(n, 0.0);
+    upward();
+
+    // target subtrees are independent: each task only writes the expansions and fields under its cell
+    frontier.assign(1, 0);
+    while (frontier.size() < Tasks){
+      next.clear();
+      for (int c : frontier){
+        if (cells[c].leaf){ next.push_back(c); continue; }
+        for (int q = 0; q < 4; ++q) if (cells[c].child[q] >= 0) next.push_back(cells[c].child[q]);
+      }
+      if (next.size() == frontier.size()) break; // all leaves
+      frontier.swap(next);
+    }
+    pool.parallelFor(frontier.size(), 1, [&](size_t begin, size_t end){
+      for (size_t k = begin; k < end; ++k){
+        interact(frontier[k], 0);
+        downward(frontier[k]);
+      }
+    });
+    for (size_t s = 0; s < n; ++s){
+      fx[perm[s]] = sfx[s];
+      fy[perm[s]] = sfy[s];
+    }
+  }
+
+  private:
+  // bodies in add() order, and results
+  std::vector<double> px, py, pm, fx, fy;
+  std::vector<int> pid;
+  // bodies sorted so every cell is a contiguous range; perm maps back to add() order
+  std::vector<int> perm;
+  std::vector<double> sx, sy, sm, sfx, sfy;
+  std::vector<Cell> cells;
+  std::vector<double> multipole, local; // nc per cell
+  std::vector<int> frontier, next;
+  int p = 1, nc = 3;
+  double theta2 = 0.25;
+  size_t directPairs = 0;
+
+  void build(){
+    const size_t n = px.size();
+    perm.resize(n);
+    std::iota(perm.begin(), perm.end(), 0);
+    double minX = px[0], maxX = px[0], minY = py[0], maxY = py[0];
+    for (size_t k = 0; k < n; ++k){
+      minX = std::min(minX, px[k]); maxX = std::max(maxX, px[k]);
+      minY = std::min(minY, py[k]); maxY = std::max(maxY, py[k]);
+    }
+    double half = std::max(maxX - minX, maxY - minY) * 0.5 + 1e-3;
+    cells.reserve(n / 4 + 16);
+    cells.push_back(makeCell((minX + maxX) * 0.5, (minY + maxY) * 0.5, half, 0, (int)n));
+    split(0, 0);
+    sx.resize(n); sy.resize(n); sm.resize(n);
+    for (size_t s = 0; s < n; ++s){
+      sx[s] = px[perm[s]];
+      sy[s] = py[perm[s]];
+      sm[s] = pm[perm[s]];
+    }
+  }
+
+  static Cell makeCell(double cx, double cy, double half, int begin, int end){
+    Cell c;
+    c.cx = cx; c.cy = cy; c.half = half;
+    c.zx = cx; c.zy = cy; c.r = 0; c.m = 0;
+    c.begin = begin; c.end = end;
+    c.child[0] = c.child[1] = c.child[2] = c.child[3] = -1;
+    c.leaf = true;
+    return c;
+  }
+
+  // cells are appended parent first, so children always have larger indices
+  void split(int c, int depth){
+    const int begin = cells[c].begin, end = cells[c].end;
+    if (end - begin <= LeafSize || depth >= MaxDepth) return;
+    const double cx = cells[c].cx, cy = cells[c].cy, h = cells[c].half * 0.5;
+    int* b = perm.data() + begin;
+    int* e = perm.data() + end;
+    int* mid = std::partition(b, e, [&](int k){ return px[k] < cx; });
+    int* lowLeft = std::partition(b, mid, [&](int k){ return py[k] < cy; });
+    int* lowRight = std::partition(mid, e, [&](int k){ return py[k] < cy; });
+    // same quadrant numbering as Gravity::Tree: +1 for x >= cx, +2 for y >= cy
+    int* from[4] = {b, mid, lowLeft, lowRight};
+    int* to[4] = {lowLeft, lowRight, mid, e};
+    cells[c].leaf = false;
+    for (int q = 0; q < 4; ++q){
+      if (from[q] == to[q]) continue;
+      int child = (int)cells.size();
+      cells.push_back(makeCell(cx + (q & 1 ? h : -h), cy + (q & 2 ? h : -h), h,
+                               (int)(from[q] - perm.data()), (int)(to[q] - perm.data())));
+      cells[c].child[q] = child;
+      split(child, depth + 1);
+    }
+  }
+
+  // mass, centre, radius and multipole moments M_k = sum m (x - z)^k / k!, children before parents
+  void upward(){
+    double ax[MaxOrder + 1], ay[MaxOrder + 1];
+    for (int c = (int)cells.size() - 1; c >= 0; --c){
+      Cell& cell = cells[c];
+      double* M = &multipole[(size_t)c * nc];
+      if (cell.leaf){
+        double m = 0, mx = 0, my = 0;
+        for (int s = cell.begin; s < cell.end; ++s){
+          m += sm[s]; mx += sm[s] * sx[s]; my += sm[s] * sy[s];
+        }
+        cell.m = m;
+        cell.zx = mx / m; cell.zy = my / m;
+        double r2 = 0;
+        for (int s = cell.begin; s < cell.end; ++s){
+          double dx = sx[s] - cell.zx, dy = sy[s] - cell.zy;
+          r2 = std::max(r2, dx*dx + dy*dy);
+          scaledPowers(dx, p, ax);
+          scaledPowers(dy, p, ay);
+          for (int n = 0; n <= p; ++n)
+            for (int bb = 0; bb <= n; ++bb) M[index(n - bb, bb)] += sm[s] * ax[n - bb] * ay[bb];
+        }
+        cell.r = std::sqrt(r2);
+        continue;
+      }
+      double m = 0, mx = 0, my = 0;
+      for (int q = 0; q < 4; ++q){
+        if (cell.child[q] < 0) continue;
+        const Cell& ch = cells[cell.child[q]];
+        m += ch.m; mx += ch.m * ch.zx; my += ch.m * ch.zy;
+      }
+      cell.m = m;
+      cell.zx = mx / m; cell.zy = my / m;
+      cell.r = 0;
+      for (int q = 0; q < 4; ++q){
+        if (cell.child[q] < 0) continue;
+        const Cell& ch = cells[cell.child[q]];
+        const double* Mc = &multipole[(size_t)cell.child[q] * nc];
+        double dx = ch.zx - cell.zx, dy = ch.zy - cell.zy;
+        cell.r = std::max(cell.r, std::sqrt(dx*dx + dy*dy) + ch.r);
+        // M_k += sum_{j <= k} Mc_j d^(k-j) / (k-j)!
+        scaledPowers(dx, p, ax);
+        scaledPowers(dy, p, ay);
+        for (int n = 0; n <= p; ++n){
+          for (int kb = 0; kb <= n; ++kb){
+            const int ka = n - kb;
+            double sum = 0;
+            for (int ja = 0; ja <= ka; ++ja)
+              for (int jb = 0; jb <= kb; ++jb) sum += Mc[index(ja, jb)] * ax[ka - ja] * ay[kb - jb];
+            M[index(ka, kb)] += sum;
+          }
+        }
+      }
+    }
+  }
+
+  // D[index(a, b)] = d^a/dx^a d^b/dy^b of 1/sqrt(x^2 + y^2 + eps^2), total degree <= p. Written as G((x^2+y^2+eps^2)/2)
+  // with G(u) = (2u)^-1/2, whose n-th derivative is (-1)^n (2n-1)!! / r^(2n+1).
+  void derivatives(double x, double y, double* D) const {
+    // c[a][i] = a! / (2^i i! (a-2i)!)
+    static const auto c = []{
+      std::vector<std::vector<double>> t(MaxOrder + 1, std::vector<double>(MaxOrder / 2 + 1, 0.0));
+      for (int a = 0; a <= MaxOrder; ++a){
+        for (int i = 0; 2 * i <= a; ++i){
+          double v = 1;
+          for (int k = a - 2 * i + 1; k <= a; ++k) v *= k;  // a! / (a-2i)!
+          for (int k = 1; k <= i; ++k) v /= 2.0 * k;        // / (2^i i!)
+          t[a][i] = v;
+        }
+      }
+      return t;
+    }();
+    const double r2 = x*x + y*y + gravitySoftening2;
+    double G[MaxOrder + 1], xp[MaxOrder + 1], yp[MaxOrder + 1];
+    G[0] = 1.0 / std::sqrt(r2);
+    const double inv2 = 1.0 / r2;
+    xp[0] = yp[0] = 1;
+    for (int n = 1; n <= p; ++n){
+      G[n] = -(2 * n - 1) * G[n - 1] * inv2;
+      xp[n] = xp[n - 1] * x;
+      yp[n] = yp[n - 1] * y;
+    }
+    for (int n = 0; n <= p; ++n){
+      for (int b = 0; b <= n; ++b){
+        const int a = n - b;
+        double sum = 0;
+        for (int i = 0; 2 * i <= a; ++i)
+          for (int j = 0; 2 * j <= b; ++j) sum += c[a][i] * c[b][j] * xp[a - 2 * i] * yp[b - 2 * j] * G[n - i - j];
+        D[index(a, b)] = sum;
+      }
+    }
+  }
+
+  void interact(int t, int s){
+    const Cell& T = cells[t];
+    const Cell& S = cells[s];
+    const double dx = T.zx - S.zx, dy = T.zy - S.zy;
+    const double reach = T.r + S.r;
+    const bool separated = reach * reach < theta2 * (dx*dx + dy*dy);
+    const size_t pairs = (size_t)(T.end - T.begin) * (size_t)(S.end - S.begin);
+    if (separated && (pairs > directPairs || !T.leaf || !S.leaf)){
+      translate(t, s, dx, dy);
+      return;
+    }
+    if (T.leaf && S.leaf){
+      direct(T, S);
+      return;
+    }
+    if (S.leaf || (!T.leaf && T.r >= S.r)){
+      for (int q = 0; q < 4; ++q) if (T.child[q] >= 0) interact(T.child[q], s);
+    } else {
+      for (int q = 0; q < 4; ++q) if (S.child[q] >= 0) interact(t, S.child[q]);
+    }
+  }
+
+  // multipole of s to local of t: L_n += sum_{|k| <= p-|n|} (-1)^|k| M_k D_{n+k}(z_t - z_s)
+  void translate(int t, int s, double dx, double dy){
+    double D[MaxCoefficients];
+    derivatives(dx, dy, D);
+    const double* M = &multipole[(size_t)s * nc];
+    double* L = &local[(size_t)t * nc];
+    for (int n = 0; n <= p; ++n){
+      for (int nb = 0; nb <= n; ++nb){
+        const int na = n - nb;
+        double sum = 0;
+        for (int k = 0; k <= p - n; ++k){
+          double part = 0;
+          for (int kb = 0; kb <= k; ++kb) part += M[index(k - kb, kb)] * D[index(na + k - kb, nb + kb)];
+          sum += k & 1 ? -part : part;
+        }
+        L[index(na, nb)] += sum;
+      }
+    }
+  }
+
+  // leaf to leaf, same arithmetic as Gravity::Tree::accumulate; a body's own term is exactly 0
+  void direct(const Cell& T, const Cell& S){
+    for (int t = T.begin; t < T.end; ++t){
+      const double x = sx[t], y = sy[t];
+      double ax = 0, ay = 0;
+      for (int s = S.begin; s < S.end; ++s){
+        double dx = sx[s] - x;
+        double dy = sy[s] - y;
+        double r2 = dx*dx + dy*dy + gravitySoftening2;
+        double invR = 1.0 / std::sqrt(r2);
+        double k = sm[s] / r2 * invR;
+        ax += dx * k;
+        ay += dy * k;
+      }
+      sfx[t] += ax;
+      sfy[t] += ay;
+    }
+  }
+
+  // pushes local expansions to the children (L_n += sum_{k >= n} Lp_k d^(k-n) / (k-n)!) and evaluates
+  // the gradient at the bodies of leaves
+  void downward(int c){
+    double ax[MaxOrder + 1], ay[MaxOrder + 1];
+    const Cell& cell = cells[c];
+    const double* L = &local[(size_t)c * nc];
+    if (cell.leaf){
+      for (int s = cell.begin; s < cell.end; ++s){
+        scaledPowers(sx[s] - cell.zx, p - 1, ax);
+        scaledPowers(sy[s] - cell.zy, p - 1, ay);
+        double gx = 0, gy = 0;
+        for (int n = 0; n < p; ++n){
+          for (int nb = 0; nb <= n; ++nb){
+            const int na = n - nb;
+            const double w = ax[na] * ay[nb];
+            gx += L[index(na + 1, nb)] * w;
+            gy += L[index(na, nb + 1)] * w;
+          }
+        }
+        sfx[s] += gx;
+        sfy[s] += gy;
+      }
+      return;
+    }
+    for (int q = 0; q < 4; ++q){
+      const int ch = cell.child[q];
+      if (ch < 0) continue;
+      double* Lc = &local[(size_t)ch * nc];
+      scaledPowers(cells[ch].zx - cell.zx, p, ax);
+      scaledPowers(cells[ch].zy - cell.zy, p, ay);
+      for (int n = 0; n <= p; ++n){
+        for (int nb = 0; nb <= n; ++nb){
+          const int na = n - nb;
+          double sum = 0;
+          for (int ka = na; ka <= p; ++ka)
+            for (int kb = nb; ka + kb <= p; ++kb) sum += L[index(ka, kb)] * ax[ka - na] * ay[kb - nb];
+          Lc[index(na, nb)] += sum;
+        }
+      }
+      downward(ch);
+    }
+  }
+};
+
+} // namespace Fmm
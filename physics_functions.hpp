@@ -1,20 +1,22 @@
 #pragma once
 #include <random>
 #include <cmath>
+#include "physics_random.hpp"
 unsigned long long UUID = 0;
 unsigned long long getUUID(){
   return UUID++;
 }
 std::random_device rd;
-std::mt19937 gen(rd());
-std::uniform_real_distribution<float> normFloat(0.0f, 1.0f); // random number generation
-std::uniform_real_distribution<float> negFloat(-1.0f, 1.0f);
+// the world's generator (World::random), for generators and colours; defined with the world
+Rng::Stream& worldRandom();
+// independent stream for one emitter in the current substep, see World::emitterStream()
+Rng::Stream emitterStream(uint64_t emitter, uint64_t other = 0);
 
-float randFloat(){
-  return normFloat(gen);
+float randFloat(Rng::Stream& rng = worldRandom()){
+  return rng.unit();
 }
-float randNegFloat(){
-  return negFloat(gen);
+float randNegFloat(Rng::Stream& rng = worldRandom()){
+  return rng.unit() * 2.0f - 1.0f;
 }
 Color randomColor(){
   Color c;
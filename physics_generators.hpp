@@ -0,0 +1,144 @@
+#pragma once
+#include "physics_engine.hpp"
+#include <cmath>
+
+// Procedural scene generators. They only spawn bodies (nothing is cleared) and draw from the world's
+// generator (World::random), so calling world.seed() first makes a scene reproducible.
+namespace SceneGen {
+
+inline double circularSpeed(double enclosedMass, double r){
+  return r > 0 ? std::sqrt(gravitationalConstant * enclosedMass / r) : 0.0;
+}
+
+// N equal bodies spread uniformly over a disc, each on a circular orbit around the enclosed mass
+inline void UniformDisc(size_t n, double radius, double totalMass, Vector2 center = {0, 0}, double bodyRadius = 2){
+  bodies.reserve(bodies.size() + n);
+  const double m = totalMass / (double)std::max<size_t>(n, 1);
+  for (size_t i = 0; i < n; ++i){
+    double r = radius * std::sqrt(randFloat());
+    double a = 2.0 * M_PI * randFloat();
+    Vector2 dir = vector(std::cos(a), std::sin(a));
+    double v = circularSpeed(totalMass * (r * r) / (radius * radius), r);
+    auto* o = bodies.spawn<PhysicsCircularObject>(center + dir * r, vector(-dir.y, dir.x) * v, randomColor(), m, bodyRadius, 0);
+    o->elasticity() = 0.5f;
+  }
+}
+
+// Plummer sphere with scale length a, projected onto the plane (Aarseth, Henon & Wielen 1974 sampling)
+inline void PlummerSphere(size_t n, double a, double totalMass, Vector2 center = {0, 0}, double bodyRadius = 2){
+  bodies.reserve(bodies.size() + n);
+  const double m = totalMass / (double)std::max<size_t>(n, 1);
+  const double vScale = std::sqrt(gravitationalConstant * totalMass / a);
+  auto randomDirection = [](double& x, double& y, double& z){
+    double cz = randNegFloat();
+    double phi = 2.0 * M_PI * randFloat();
+    double sz = std::sqrt(std::max(0.0, 1.0 - cz * cz));
+    x = sz * std::cos(phi); y = sz * std::sin(phi); z = cz;
+  };
+  for (size_t i = 0; i < n; ++i){
+    double u = std::max(randFloat(), 1e-6f);
+    double r = 1.0 / std::sqrt(std::pow(u, -2.0 / 3.0) - 1.0);
+    r = std::min(r, 20.0); // drop the far tail
+    double x, y, z;
+    randomDirection(x, y, z);
+    // velocity fraction q of the escape speed, rejection sampled from q^2 (1-q^2)^3.5
+    double q = 0, g = 0.1;
+    while (g > q * q * std::pow(1.0 - q * q, 3.5)){
+      q = randFloat();
+      g = 0.1 * randFloat();
+    }
+    double v = q * std::sqrt(2.0) * std::pow(1.0 + r * r, -0.25);
+    double vx, vy, vz;
+    randomDirection(vx, vy, vz);
+    bodies.spawn<PhysicsCircularObject>(center + vector(x, y) * (r * a), vector(vx, vy) * (v * vScale), randomColor(), m, bodyRadius, 0);
+  }
+}
+
+// Columns of touching rectangles standing on a fixed floor, under constant downward gravity
+inline void RectangleStacks(size_t n, Vector2 boxSize = {10, 10}, size_t columns = 0, Vector2 origin = {0, 0}){
+  bodies.reserve(bodies.size() + n + 1);
+  if (columns == 0) columns = std::max<size_t>(1, (size_t)std::sqrt((double)n));
+  size_t rows = (n + columns - 1) / columns;
+  double width = columns * boxSize.x * 1.5;
+  auto* floor = bodies.spawn<PhysicsRectangularObject>(origin + vector(width / 2, boxSize.y * 0.5), vector(), (Color){120, 120, 120, 255}, 1e9, vector(width + boxSize.x * 2, boxSize.y), 0);
+  floor->fixed() = true;
+  for (size_t i = 0; i < n; ++i){
+    size_t c = i % columns, r = i / columns;
+    Vector2 p = origin + vector(boxSize.x * (0.75 + 1.5 * c), -boxSize.y * (double)(rows - r) + 0.01 * randNegFloat());
+    auto* o = bodies.spawn<PhysicsRectangularObject>(p, vector(), randomColor(), 1, boxSize, 0);
+    o->gravityAffected() = true;
+    o->elasticity() = 0.2f;
+  }
+}
+
+// Fireworks launched outwards from a disc (spread 0 => sqrt(n)*4) with random directions and short fuses
+inline void FireworkStorm(size_t n, double speed = 100, double fuse = 1.5, Vector2 origin = {0, 0}, double spread = 0){
+  bodies.reserve(bodies.size() + n);
+  if (spread <= 0) spread = 4.0 * std::sqrt((double)n);
+  for (size_t i = 0; i < n; ++i){
+    double a = 2.0 * M_PI * randFloat();
+    Vector2 dir = vector(std::cos(a), std::sin(a));
+    Vector2 p = origin + dir * (spread * std::sqrt(randFloat()));
+    bodies.spawn<Firework>(p, dir * (speed * (0.5 + randFloat())), randomColor(), 1, 2, 0.0, fuse * (0.5 + randFloat()));
+  }
+}
+
+// Velocity for a circular orbit at pos around a body of mass centralMass at center moving with centerSpeed
+inline Vector2 orbitVelocity(Vector2 pos, Vector2 center, Vector2 centerSpeed, double centralMass){
+  Vector2 r = {pos.x - center.x, pos.y - center.y};
+  double rlen = std::sqrt((double)r.x * r.x + (double)r.y * r.y);
+  if (rlen <= 0 || centralMass <= 0) return centerSpeed;
+  double v = circularSpeed(centralMass, rlen);
+  return centerSpeed + vector(-r.y / rlen, r.x / rlen) * v;
+}
+
+// ---- placements for bulk creation ----
+// These reserve room for n bodies once and then call place(pos, speed) for each; the caller spawns the
+// body and sets the rest of its properties, e.g. from the editor template.
+
+// Bodies spread uniformly over an annulus, on circular (Keplerian) orbits around a central mass
+template<class F>
+void KeplerDisc(size_t n, double inner, double outer, double centralMass, Vector2 center, Vector2 centerSpeed, F place){
+  bodies.reserve(bodies.size() + n);
+  for (size_t i = 0; i < n; ++i){
+    double r = std::sqrt(inner * inner + (outer * outer - inner * inner) * randFloat());
+    double a = 2.0 * M_PI * randFloat();
+    Vector2 p = center + vector(std::cos(a), std::sin(a)) * r;
+    place(p, orbitVelocity(p, center, centerSpeed, centralMass));
+  }
+}
+
+// Bodies at rest on a square grid width across, centred on center
+template<class F>
+void Grid(size_t n, double width, Vector2 center, F place){
+  bodies.reserve(bodies.size() + n);
+  size_t side = std::max<size_t>(1, (size_t)std::ceil(std::sqrt((double)n)));
+  double spacing = side > 1 ? width / (double)(side - 1) : 0;
+  double half = width / 2;
+  for (size_t i = 0; i < n; ++i)
+    place(center + vector(spacing * (double)(i % side) - half, spacing * (double)(i / side) - half), vector());
+}
+
+// Bodies at rest, spread uniformly over a disc
+template<class F>
+void Cloud(size_t n, double radius, Vector2 center, F place){
+  bodies.reserve(bodies.size() + n);
+  for (size_t i = 0; i < n; ++i){
+    double r = radius * std::sqrt(randFloat());
+    double a = 2.0 * M_PI * randFloat();
+    place(center + vector(std::cos(a), std::sin(a)) * r, vector());
+  }
+}
+
+// Bodies evenly spaced on one circular orbit around a central body
+template<class F>
+void Ring(size_t n, double radius, double centralMass, Vector2 center, Vector2 centerSpeed, F place){
+  bodies.reserve(bodies.size() + n);
+  for (size_t i = 0; i < n; ++i){
+    double a = 2.0 * M_PI * (double)i / (double)n;
+    Vector2 p = center + vector(std::cos(a), std::sin(a)) * radius;
+    place(p, orbitVelocity(p, center, centerSpeed, centralMass));
+  }
+}
+
+} // namespace SceneGen
@@ -0,0 +1,162 @@
+#pragma once
+#include "physics_variables.hpp"
+#include <vector>
+#include <cmath>
+
+// Barnes-Hut quadtree for gravity. Bodies are added as plain values (no Object pointers),
+// the tree is built once and then queried per body with the opening angle barnesHutTheta.
+namespace Gravity {
+
+struct Body {
+  double x, y, m;
+  int id;
+  int next; // next body in the same leaf (only used at max depth / coincident points)
+};
+
+struct Node {
+  double cx, cy, half;   // square cell: center and half size
+  double m, comx, comy;  // total mass and center of mass
+  int child;             // index of the first of 4 consecutive children, -1 for leaves
+  int body;              // head of the body list for leaves, -1 if empty
+};
+
+class Tree {
+  public:
+  static const int MAX_DEPTH = 48;
+
+  void clear(){
+    bodies.clear();
+    nodes.clear();
+  }
+  void add(double x, double y, double m, int id){
+    bodies.push_back({x, y, m, id, -1});
+  }
+  size_t size() const { return bodies.size(); }
+
+  void build(){
+    nodes.clear();
+    if (bodies.empty()) return;
+    double minX = bodies[0].x, maxX = bodies[0].x;
+    double minY = bodies[0].y, maxY = bodies[0].y;
+    for (const auto& b : bodies){
+      minX = std::min(minX, b.x); maxX = std::max(maxX, b.x);
+      minY = std::min(minY, b.y); maxY = std::max(maxY, b.y);
+    }
+    double half = std::max(maxX - minX, maxY - minY) * 0.5 + 1e-3;
+    nodes.reserve(bodies.size() * 2 + 1);
+    nodes.push_back({(minX + maxX) * 0.5, (minY + maxY) * 0.5, half, 0, 0, 0, -1, -1});
+    for (int b = 0; b < (int)bodies.size(); ++b) insert(b);
+    summarize(0);
+  }
+
+  // Sum of M*d/|d|^3 (softened) over all bodies except the one with id `self`; multiply by G*m for the force.
+  void field(double x, double y, int self, double& fx, double& fy) const {
+    fx = 0; fy = 0;
+    if (nodes.empty()) return;
+    const double theta2 = barnesHutTheta * barnesHutTheta;
+    int stack[4 * MAX_DEPTH + 8];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0){
+      const Node& n = nodes[stack[--top]];
+      if (n.m == 0) continue;
+      if (n.child < 0){
+        for (int b = n.body; b != -1; b = bodies[b].next){
+          const Body& o = bodies[b];
+          if (o.id == self) continue;
+          accumulate(x, y, o.x, o.y, o.m, fx, fy);
+        }
+        continue;
+      }
+      double dx = n.comx - x;
+      double dy = n.comy - y;
+      double d2 = dx*dx + dy*dy;
+      double size = 2.0 * n.half;
+      bool inside = std::fabs(x - n.cx) <= n.half && std::fabs(y - n.cy) <= n.half;
+      if (!inside && size*size < theta2 * d2){
+        accumulate(x, y, n.comx, n.comy, n.m, fx, fy);
+        continue;
+      }
+      for (int c = 0; c < 4; ++c) stack[top++] = n.child + c;
+    }
+  }
+
+  private:
+  std::vector<Body> bodies;
+  std::vector<Node> nodes;
+
+  static void accumulate(double x, double y, double ox, double oy, double m, double& fx, double& fy){
+    double dx = ox - x;
+    double dy = oy - y;
+    double r2 = dx*dx + dy*dy + gravitySoftening2;
+    double invR = 1.0 / std::sqrt(r2);
+    double s = m / r2 * invR;
+    fx += dx * s;
+    fy += dy * s;
+  }
+
+  int quadrant(const Node& n, const Body& b) const {
+    return (b.x >= n.cx ? 1 : 0) + (b.y >= n.cy ? 2 : 0);
+  }
+
+  void split(int ni){
+    int first = (int)nodes.size();
+    double h = nodes[ni].half * 0.5;
+    double cx = nodes[ni].cx, cy = nodes[ni].cy;
+    for (int q = 0; q < 4; ++q){
+      nodes.push_back({cx + ((q & 1) ? h : -h), cy + ((q & 2) ? h : -h), h, 0, 0, 0, -1, -1});
+    }
+    nodes[ni].child = first;
+    // move the resident bodies down one level
+    int b = nodes[ni].body;
+    nodes[ni].body = -1;
+    while (b != -1){
+      int next = bodies[b].next;
+      bodies[b].next = -1;
+      int c = first + quadrant(nodes[ni], bodies[b]);
+      bodies[b].next = nodes[c].body;
+      nodes[c].body = b;
+      b = next;
+    }
+  }
+
+  void insert(int b){
+    int ni = 0;
+    for (int depth = 0; ; ++depth){
+      if (nodes[ni].child < 0){
+        if (nodes[ni].body == -1 || depth >= MAX_DEPTH){
+          bodies[b].next = nodes[ni].body;
+          nodes[ni].body = b;
+          return;
+        }
+        split(ni);
+        // a split may leave every resident body in one child; keep descending
+      }
+      ni = nodes[ni].child + quadrant(nodes[ni], bodies[b]);
+    }
+  }
+
+  void summarize(int ni){
+    double m = 0, mx = 0, my = 0;
+    if (nodes[ni].child < 0){
+      for (int b = nodes[ni].body; b != -1; b = bodies[b].next){
+        m  += bodies[b].m;
+        mx += bodies[b].m * bodies[b].x;
+        my += bodies[b].m * bodies[b].y;
+      }
+    } else {
+      for (int c = 0; c < 4; ++c){
+        int ci = nodes[ni].child + c;
+        summarize(ci);
+        m  += nodes[ci].m;
+        mx += nodes[ci].m * nodes[ci].comx;
+        my += nodes[ci].m * nodes[ci].comy;
+      }
+    }
+    nodes[ni].m = m;
+    nodes[ni].comx = m != 0 ? mx / m : nodes[ni].cx;
+    nodes[ni].comy = m != 0 ? my / m : nodes[ni].cy;
+  }
+};
+
+} // namespace Gravity
@@ -0,0 +1,183 @@
+#pragma once
+#include "physics_world.hpp"
+#include "physics_snapshot.hpp"
+#include "physics_recorder.hpp"
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <cinttypes>
+#include <vector>
+
+// Headless batch mode: no window, fixed dt, as fast as the CPU allows.
+//   physics --headless <scene.csv> [--steps N] [--dt seconds] [--out final.csv]
+//           [--every K --snapshots prefix] [--threads T] [--exact] [--theta θ] [--integrator name]
+//           [--solver exact|barnes-hut|fmm] [--order p] [--fmm-theta θ]
+//           [--record trajectory.trj] [--profile trace.json] [--kernel isa] [--precision double|float]
+//           [--seed X] [--hash-out hashes.txt | --hash-check hashes.txt]
+// Every K steps the state is written to <prefix>_<step>.csv. The scene may be CSV or a binary snapshot;
+// an --out ending in .phys writes binary snapshots, for the periodic ones too.
+// Runs are seeded (default 1), so the same scene and options replay bit for bit. --hash-out writes
+// StateHash() after every step, one "step hash" line each; --hash-check recomputes them and stops at
+// the first step that differs from the recorded run.
+struct HeadlessOptions {
+  std::string scene;
+  std::string out = "final.csv";
+  std::string snapshots = "snapshot";
+  long long steps = 600;
+  long long every = 0;   // 0 => no periodic snapshots
+  double dt = 1.0 / 60.0;
+  std::string integrator; // empty => whatever the scene file says
+  std::string record;     // trajectory file, every step
+  std::string profile;    // Chrome trace of the whole run
+  uint64_t seed = 1;
+  std::string hashOut;    // per-step state hashes, written
+  std::string hashCheck;  // per-step state hashes, compared against
+};
+
+// "step hash" lines of a --hash-out file, indexed by step; false if it can't be read
+static bool ReadStateHashes(const char* path, std::vector<uint64_t>& hashes){
+  FILE* f = std::fopen(path, "r");
+  if (!f) return false;
+  long long step;
+  uint64_t h;
+  hashes.assign(1, 0);
+  while (std::fscanf(f, "%lld %" SCNx64, &step, &h) == 2){
+    if (step < 1) continue;
+    if ((size_t)step >= hashes.size()) hashes.resize(step + 1, 0);
+    hashes[step] = h;
+  }
+  std::fclose(f);
+  return true;
+}
+
+static void PrintHeadlessUsage(){
+  std::fprintf(stderr,
+    "usage: physics --headless <scene.csv> [--steps N] [--dt seconds] [--out final.csv]\n"
+    "                [--every K] [--snapshots prefix] [--threads T] [--exact] [--theta value]\n"
+    "                [--integrator euler|leapfrog|yoshida4|adaptive] [--record trajectory.trj]\n"
+    "                [--solver exact|barnes-hut|fmm] [--order p] [--fmm-theta value]\n"
+    "                [--profile trace.json] [--kernel scalar|sse2|avx2|avx512] [--precision double|float]\n"
+    "                [--seed X] [--hash-out hashes.txt | --hash-check hashes.txt]\n");
+}
+
+// One frame without drawing, same order as the window loop
+void HeadlessTick(double dt){
+  Profiler::Scope zone(Profiler::Phase::Tick);
+  bodies.removeMarked();
+  world.step(dt);
+  {
+    Profiler::Scope zone(Profiler::Phase::Particles);
+    particles.update(dt);
+  }
+  Profiler::Scope bodiesZone(Profiler::Phase::Bodies);
+  ++world.ticks;
+  for (size_t j = 0; j < bodies.size(); ++j){
+    if (bodies.flags[j].shouldRemove) continue;
+    bodies.handle[j]->tick(dt);
+  }
+}
+
+int RunHeadless(int argc, char** argv){
+  HeadlessOptions opt;
+  for (int i = 0; i < argc; ++i){
+    const char* a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(a, "--steps") == 0 && hasValue) opt.steps = std::atoll(argv[++i]);
+    else if (std::strcmp(a, "--dt") == 0 && hasValue) opt.dt = std::atof(argv[++i]);
+    else if (std::strcmp(a, "--out") == 0 && hasValue) opt.out = argv[++i];
+    else if (std::strcmp(a, "--every") == 0 && hasValue) opt.every = std::atoll(argv[++i]);
+    else if (std::strcmp(a, "--snapshots") == 0 && hasValue) opt.snapshots = argv[++i];
+    else if (std::strcmp(a, "--threads") == 0 && hasValue) threadPool.resize((unsigned)std::atoi(argv[++i]));
+    else if (std::strcmp(a, "--theta") == 0 && hasValue) barnesHutTheta = std::atof(argv[++i]);
+    else if (std::strcmp(a, "--integrator") == 0 && hasValue) opt.integrator = argv[++i];
+    else if (std::strcmp(a, "--record") == 0 && hasValue) opt.record = argv[++i];
+    else if (std::strcmp(a, "--profile") == 0 && hasValue) opt.profile = argv[++i];
+    else if (std::strcmp(a, "--seed") == 0 && hasValue) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (std::strcmp(a, "--hash-out") == 0 && hasValue) opt.hashOut = argv[++i];
+    else if (std::strcmp(a, "--hash-check") == 0 && hasValue) opt.hashCheck = argv[++i];
+    else if (std::strcmp(a, "--kernel") == 0 && hasValue){
+      if (!Simd::parseIsa(argv[++i], gravityIsa)){ PrintHeadlessUsage(); return 2; }
+    }
+    else if (std::strcmp(a, "--precision") == 0 && hasValue){
+      if (!Simd::parsePrecision(argv[++i], gravityPrecision)){ PrintHeadlessUsage(); return 2; }
+    }
+    else if (std::strcmp(a, "--solver") == 0 && hasValue){
+      if (!ParseGravitySolver(argv[++i], gravitySolver)){ PrintHeadlessUsage(); return 2; }
+    }
+    else if (std::strcmp(a, "--order") == 0 && hasValue) fmmOrder = std::atoi(argv[++i]);
+    else if (std::strcmp(a, "--fmm-theta") == 0 && hasValue) fmmTheta = std::atof(argv[++i]);
+    else if (std::strcmp(a, "--exact") == 0) gravitySolver = GravitySolver::Exact;
+    else if (a[0] != '-' && opt.scene.empty()) opt.scene = a;
+    else { PrintHeadlessUsage(); return 2; }
+  }
+  if (opt.scene.empty() || (!opt.hashOut.empty() && !opt.hashCheck.empty())){ PrintHeadlessUsage(); return 2; }
+
+  SceneLoadReport loaded = LoadScene(opt.scene.c_str());
+  for (const auto& e : loaded.errors)
+    std::fprintf(stderr, "headless: %s:%zu: %s\n", opt.scene.c_str(), e.line, e.message.c_str());
+  if (loaded.errorCount > loaded.errors.size())
+    std::fprintf(stderr, "headless: %zu more bad rows skipped\n", loaded.errorCount - loaded.errors.size());
+  if (bodies.empty()){
+    std::fprintf(stderr, "headless: no bodies loaded from %s\n", opt.scene.c_str());
+    return 1;
+  }
+  if (!opt.integrator.empty() && !ParseIntegrator(opt.integrator, integrator)){
+    PrintHeadlessUsage();
+    return 2;
+  }
+
+  bool binary = opt.out.size() >= 5 && opt.out.compare(opt.out.size() - 5, 5, ".phys") == 0;
+  const char* extension = binary ? ".phys" : ".csv";
+  FILE* hashOut = nullptr;
+  std::vector<uint64_t> expected;
+  if (!opt.hashOut.empty() && !(hashOut = std::fopen(opt.hashOut.c_str(), "w"))){
+    std::fprintf(stderr, "headless: cannot write %s\n", opt.hashOut.c_str());
+    return 1;
+  }
+  if (!opt.hashCheck.empty() && !ReadStateHashes(opt.hashCheck.c_str(), expected)){
+    std::fprintf(stderr, "headless: cannot read %s\n", opt.hashCheck.c_str());
+    return 1;
+  }
+  if (!opt.record.empty() && !recorder.start(opt.record.c_str())){
+    std::fprintf(stderr, "headless: cannot write %s\n", opt.record.c_str());
+    if (hashOut) std::fclose(hashOut);
+    return 1;
+  }
+  if (!opt.profile.empty()){
+    Profiler::setThreadName("headless");
+    Profiler::beginCapture();
+  }
+  world.seed(opt.seed);
+  long long diverged = 0; // first step whose hash differs from --hash-check, 0 => none
+  auto start = std::chrono::steady_clock::now();
+  for (long long s = 1; s <= opt.steps; ++s){
+    HeadlessTick(opt.dt);
+    recorder.record(opt.dt);
+    if (hashOut) std::fprintf(hashOut, "%lld %016" PRIx64 "\n", s, StateHash());
+    if (!opt.hashCheck.empty() && (size_t)s < expected.size() && StateHash() != expected[s]){
+      diverged = s;
+      break;
+    }
+    if (opt.every > 0 && s % opt.every == 0){
+      std::string path = opt.snapshots + "_" + std::to_string(s) + extension;
+      SaveScene(path.c_str());
+    }
+  }
+  recorder.stop();
+  if (hashOut) std::fclose(hashOut);
+  if (diverged)
+    std::fprintf(stderr, "headless: state differs from %s at step %lld\n", opt.hashCheck.c_str(), diverged);
+  else if (!opt.hashCheck.empty())
+    std::fprintf(stderr, "headless: %lld steps match %s\n", std::min<long long>(opt.steps, (long long)expected.size() - 1), opt.hashCheck.c_str());
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (!opt.profile.empty() && Profiler::endCapture(opt.profile.c_str()) < 0)
+    std::fprintf(stderr, "headless: cannot write %s\n", opt.profile.c_str());
+  bodies.removeMarked();
+  SaveScene(opt.out.c_str());
+
+  std::fprintf(stderr, "headless: %lld steps of %g s (%g s simulated) in %.3f s wall, %zu bodies, %u threads, %s\n",
+               opt.steps, opt.dt, opt.steps * opt.dt, wall, bodies.size(), threadPool.size(), integratorNames[(int)integrator]);
+  ClearScene();
+  return diverged ? 1 : 0;
+}
@@ -1,121 +1,109 @@
 #pragma once
 #include "raylib.h"
 #include "physics_variables.hpp"
-#include <map>
-#include <string>
+#include <string_view>
 
-static std::map<std::string, std::map<std::string, std::string>> STR = {
+// ---------------- localisation ----------------
+// One row per string: id, English, Russian. The ids become the Str enum and every language a flat
+// string_view array in enum order, so L(Str::X) is one index into the active language, resolved once by
+// SetLanguage(). The texts are string literals, so data() of a result is null-terminated for C APIs.
+#define LOCALISATION_TABLE(X) \
+    /* -------- Editor panel base labels -------- */ \
+    X(EditorTitleTemplate,  "New Object Template",            "Шаблон нового объекта") \
+    X(EditorTitleObject,    "Edit Object",                    "Редактирование объекта") \
+    X(EditorTitleSelection, "Edit Selection",                 "Редактирование выделения") \
+    X(EditorSelected,       "Selected: ",                     "Выбрано: ") \
+    X(EditorMass,           "Mass",                           "Масса") \
+    X(EditorFriction,       "Friction",                       "Коэфф. трения") \
+    X(EditorElasticity,     "Elasticity",                     "Упругость") \
+    X(EditorGravity,        "Gravity",                        "Гравитация") \
+    X(EditorFixed,          "Fixed",                          "Статичность") \
+    X(EditorSpeedX,         "Speed X",                        "Скорость по X") \
+    X(EditorSpeedY,         "Speed Y",                        "Скорость по Y") \
+    X(EditorTrail,          "Trail",                          "След") \
+    X(EditorRadius,         "Radius",                         "Радиус") \
+    X(EditorColorR,         "Red",                            "Красный") \
+    X(EditorColorG,         "Green",                          "Зеленый") \
+    X(EditorColorB,         "Blue",                           "Синий") \
+    X(EditorGenerator,      "Generator",                      "Генератор") \
+    X(EditorCount,          "Count",                          "Количество") \
+    X(EditorSize,           "Size",                           "Размер") \
+    X(EditorCentralMass,    "Central mass",                   "Центральная масса") \
+    X(GenSingle,            "Single body",                    "Одно тело") \
+    X(GenDisc,              "Kepler disc",                    "Кеплеров диск") \
+    X(GenGrid,              "Grid",                           "Сетка") \
+    X(GenCloud,             "Random cloud",                   "Случайное облако") \
+    /* -------- Buttons -------- */ \
+    X(BtnClose,             "Close",                          "Закрыть") \
+    X(BtnDelete,            "Delete",                         "Удалить") \
+    X(BtnOrbit,             "Orbit...",                       "Орбита...") \
+    X(BtnRing,              "Ring",                           "Кольцо") \
+    /* -------- Small UI elements -------- */ \
+    X(UiScale,              "Scale: ",                        "Масштаб: ") \
+    X(UiTime,               "Time: ",                         "Время: ") \
+    X(UiTrailLifetime,      "Trail lifetime: ",               "Время следа: ") \
+    X(UiVisualScaling,      "Visual scaling: ",               "Визуальный масштаб: ") \
+    X(UiGravityBarnesHut,   "Gravity: Barnes-Hut, theta=",    "Гравитация: Барнс-Хат, theta=") \
+    X(UiGravityFmm,         "Gravity: multipole, order=",     "Гравитация: мультиполи, порядок=") \
+    X(UiGravityExact,       "Gravity: exact",                 "Гравитация: точная") \
+    X(UiPairs,              "Collision pairs: ",              "Пары столкновений: ") \
+    X(UiPairsPruned,        ", pruned: ",                     ", отсеяно: ") \
+    X(UiIntegrator,         "Integrator: ",                   "Интегратор: ") \
+    X(UiRecording,          "REC frames: ",                   "ЗАПИСЬ кадров: ") \
+    X(UiReplay,             "Replay frame ",                  "Повтор кадр ") \
+    X(UiSimRate,            "Simulation: ",                   "Симуляция: ") \
+    X(UiHz,                 " ticks/s",                       " тиков/с") \
+    X(UiProfiler,           "phase     ms/frame   max calls", "фаза      мс/кадр   макс вызовы") \
+    X(UiProfilerCapturing,  " [TRACE]",                       " [ТРАССА]") \
+    X(UiProfilerBodies,     "bodies: ",                       "тел: ") \
+    X(UiProfilerParticles,  ", particles: ",                  ", частиц: ") \
+    X(UiDrawn,              "Drawn: ",                        "Отрисовано: ") \
+    X(UiCulled,             ", culled: ",                     ", отсечено: ") \
+    X(UiVertices,           ", vertices: ",                   ", вершин: ") \
+    X(UiSaving,             "Saving ",                        "Сохранение ") \
+    X(UiSaved,              "Saved ",                         "Сохранено ") \
+    X(UiSaveFailed,         "Save failed: ",                  "Ошибка сохранения: ") \
+    X(UiMadeBy,             "Made by ",                       "Создал ") \
+    X(CreatorMyName,        "Miron Samokhvalov",              "Мирон Самохвалов")
 
-    // -------- Editor panel base labels --------
-    { "editor.title.template", {
-        {"en", "New Object Template"},
-        {"ru", "Шаблон нового объекта"}
-    }},
-    { "editor.title.object", {
-        {"en", "Edit Object"},
-        {"ru", "Редактирование объекта"}
-    }},
+enum class Str {
+#define X(id, en, ru) id,
+    LOCALISATION_TABLE(X)
+#undef X
+    Count
+};
 
-    { "editor.mass", {
-        {"en", "Mass"},
-        {"ru", "Масса"}
-    }},
-    { "editor.friction", {
-        {"en", "Friction"},
-        {"ru", "Коэфф. трения"}
-    }},
-    { "editor.elasticity", {
-        {"en", "Elasticity"},
-        {"ru", "Упругость"}
-    }},
-    { "editor.gravity", {
-        {"en", "Gravity"},
-        {"ru", "Гравитация"}
-    }},
-    { "editor.fixed", {
-        {"en", "Fixed"},
-        {"ru", "Статичность"}
-    }},
-    { "editor.speed_x", {
-        {"en", "Speed X"},
-        {"ru", "Скорость по X"}
-    }},
-    { "editor.speed_y", {
-        {"en", "Speed Y"},
-        {"ru", "Скорость по Y"}
-    }},
-    { "editor.trail", {
-        {"en", "Trail"},
-        {"ru", "След"}
-    }},
-    { "editor.radius", {
-        {"en", "Radius"},
-        {"ru", "Радиус"}
-    }},
-    { "editor.color_r", {
-        {"en", "Red"},
-        {"ru", "Красный"}
-    }},
-    { "editor.color_g", {
-        {"en", "Green"},
-        {"ru", "Зеленый"}
-    }},
-    { "editor.color_b", {
-        {"en", "Blue"},
-        {"ru", "Синий"}
-    }},
+const char* languageNames[] = {"en", "ru"};
+constexpr int languageCount = 2;
 
-    // -------- Buttons --------
-    { "btn.close", {
-        {"en", "Close"},
-        {"ru", "Закрыть"}
-    }},
-    { "btn.delete", {
-        {"en", "Delete"},
-        {"ru", "Удалить"}
-    }},
-    { "btn.orbit", {
-        {"en", "Orbit..."},
-        {"ru", "Орбита..."}
-    }},
+constexpr std::string_view localisedText[languageCount][(int)Str::Count] = {
+#define X(id, en, ru) en,
+    { LOCALISATION_TABLE(X) },
+#undef X
+#define X(id, en, ru) ru,
+    { LOCALISATION_TABLE(X) },
+#undef X
+};
 
-    // -------- Small UI elements --------
-    { "ui.scale", {
-        {"en", "Scale: "},
-        {"ru", "Масштаб: "}
-    }},
-    { "ui.time", {
-        {"en", "Time: "},
-        {"ru", "Время: "}
-    }},
-    { "ui.trail_lifetime", {
-        {"en", "Trail lifetime: "},
-        {"ru", "Время следа: "}
-    }},
-    { "ui.visual_scaling", {
-        {"en", "Visual scaling: "},
-        {"ru", "Визуальный масштаб: "}
-    }},
-    { "ui.madeby", {
-        {"en", "Made by "},
-        {"ru", "Создал "}
-    }},
+const std::string_view* activeText = localisedText[0];
 
-    { "creator.myname", {
-        {"en", "Miron Samokhvalov"},
-        {"ru", "Мирон Самохвалов"}
-    }},
-};
-std::string L(const std::string& key, const std::string& l) {
-    if (STR.count(key) && STR.at(key).count(l))
-        return STR.at(key).at(l);
-    return key;
+// Sets lang and the table L() reads; unknown languages fall back to English
+void SetLanguage(const char* l) {
+    for (int k = 0; k < languageCount; ++k) {
+        if (std::string_view(l) == languageNames[k]) {
+            lang = languageNames[k];
+            activeText = localisedText[k];
+            return;
+        }
+    }
+    lang = languageNames[0];
+    activeText = localisedText[0];
 }
-std::string L(const std::string& key) {
-    if (STR.count(key) && STR.at(key).count(lang))
-        return STR.at(key).at(lang);
-    return key+lang;
+
+inline std::string_view L(Str id) {
+    return activeText[(int)id];
 }
+
 void LoadUIFont() {
     const int FONT_SIZE = 24;
     int codepoints[351];
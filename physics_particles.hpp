@@ -0,0 +1,85 @@
+#pragma once
+#include "physics_variables.hpp"
+#include "physics_functions.hpp"
+#include "raylib.h"
+#include <vector>
+#include <algorithm>
+
+// Massless visual particles (explosion debris, trails). They live in a fixed-capacity pool of plain
+// arrays outside bodies: never collided, never saved, drawn from the copy in SimView. Emitting into a full pool
+// overwrites slots round-robin instead of growing, so a firework storm costs no allocations.
+class ParticleSystem {
+  public:
+  static constexpr float friction = 0.02f;
+
+  std::vector<Vector2> pos;
+  std::vector<Vector2> speed;
+  std::vector<float> radius;
+  std::vector<float> age;
+  std::vector<float> life;  // seconds until gone; < 0 => trail, fades over trailLifetime
+  std::vector<Color> color;
+
+  explicit ParticleSystem(size_t capacity){
+    pos.resize(capacity); speed.resize(capacity); radius.resize(capacity);
+    age.resize(capacity); life.resize(capacity); color.resize(capacity);
+  }
+
+  size_t size() const { return count; }
+  size_t capacity() const { return pos.size(); }
+
+  void emit(Vector2 p, Vector2 v, Color c, double r, double lifeSeconds){
+    size_t k;
+    if (count < capacity()) k = count++;
+    else { k = evict++ % capacity(); }
+    pos[k] = p; speed[k] = v; color[k] = c;
+    radius[k] = (float)r; age[k] = 0; life[k] = (float)lifeSeconds;
+  }
+  void emitTrail(Vector2 p, Color c, double r){ emit(p, vector(0, 0), c, r, -1); }
+
+  // ages and moves every particle, swap-removing the expired ones
+  void update(double dt){
+    const float h = (float)dt;
+    const float damp = 1 - friction * h;
+    const float trailLife = (float)trailLifetime;
+    size_t k = 0;
+    while (k < count){
+      age[k] += h;
+      float l = life[k] < 0 ? trailLife : life[k];
+      if (age[k] >= l){
+        kill(k);
+        continue;
+      }
+      pos[k] += speed[k] * h;
+      speed[k] *= damp;
+      ++k;
+    }
+  }
+
+  // copies the live particles out for drawing, colors faded by age
+  void capture(std::vector<Vector2>& outPos, std::vector<float>& outRadius, std::vector<Color>& outColor) const {
+    const float trailLife = (float)trailLifetime;
+    outPos.assign(pos.begin(), pos.begin() + count);
+    outRadius.assign(radius.begin(), radius.begin() + count);
+    outColor.resize(count);
+    for (size_t k = 0; k < count; ++k){
+      float l = life[k] < 0 ? trailLife : life[k];
+      Color c = color[k];
+      c.a = (unsigned char)(255.0f * std::max(0.0f, 1.0f - age[k] / l));
+      outColor[k] = c;
+    }
+  }
+
+  void clear(){ count = 0; evict = 0; }
+
+  private:
+  size_t count = 0;
+  size_t evict = 0; // next slot to overwrite once the pool is full
+
+  void kill(size_t k){
+    size_t last = --count;
+    pos[k] = pos[last]; speed[k] = speed[last]; radius[k] = radius[last];
+    age[k] = age[last]; life[k] = life[last]; color[k] = color[last];
+  }
+};
+
+ParticleSystem particles(1 << 16);
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+// ---------------- random numbers ----------------
+// Counter-based generator: draw n of a stream is a pure function of (key, n), the SplitMix64 output
+// function applied to key + n * gamma. A run is therefore reproducible from its seed alone, and
+// split(id) derives an independent stream per task, so code running on the thread pool can draw
+// numbers that depend on the task index rather than on which thread ran it.
+namespace Rng {
+
+// SplitMix64 finaliser
+inline uint64_t mix(uint64_t z){
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+class Stream {
+  public:
+  static constexpr uint64_t gamma = 0x9e3779b97f4a7c15ull;
+
+  explicit Stream(uint64_t s = 0){ seed(s); }
+
+  void seed(uint64_t s){
+    key = mix(s);
+    counter = 0;
+  }
+  uint64_t next(){ return mix(key + ++counter * gamma); }
+  // [0,1) from the top 24 bits, every value exactly representable as a float
+  float unit(){ return (float)(next() >> 40) * (1.0f / 16777216.0f); }
+
+  Stream split(uint64_t id) const {
+    Stream s;
+    s.key = mix(key ^ mix(id + gamma));
+    return s;
+  }
+
+  private:
+  uint64_t key = 0, counter = 0;
+};
+
+} // namespace Rng
@@ -0,0 +1,394 @@
+#pragma once
+#include "physics_engine.hpp"
+#include "physics_snapshot.hpp"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+// ---------------- trajectory recording & replay ----------------
+// A trajectory file is a header ("PTRJ", u16 version, u16 keyframe interval) followed by chunks:
+//   "CHNK", u32 payload bytes, u32 frames, u64 first frame | frames
+// Every chunk starts with a keyframe, so seeking decodes at most one chunk. A frame is u8 type, f64 time, then
+//   keyframe  u32 count, per body: u64 uuid, u8 shape, u8 r g b, f32 size x/y, f32 pos x/y, speed x/y
+//   delta     per body: pos x/y, speed x/y as zigzag varints; each is the change of the float bit pattern
+//             minus its change in the previous frame (0 right after a keyframe), so steady motion codes small
+// Deltas are lossless and only written while the set of bodies is unchanged; a merge, spawn or removal
+// forces a keyframe. Size and color are keyframe-only.
+namespace Trajectory {
+
+const char Magic[4] = {'P', 'T', 'R', 'J'};
+const char ChunkMagic[4] = {'C', 'H', 'N', 'K'};
+const uint16_t Version = 1;
+const size_t HeaderSize = 8;
+const size_t ChunkHeaderSize = 20;
+enum FrameType : uint8_t { Keyframe = 0, Delta = 1 };
+
+template<class T>
+inline void append(std::vector<uint8_t>& out, T v){
+  uint8_t b[sizeof(T)];
+  uint8_t* p = b;
+  Snapshot::put<T>(p, v);
+  out.insert(out.end(), b, b + sizeof(T));
+}
+inline void appendVarint(std::vector<uint8_t>& out, int64_t d){
+  uint64_t v = ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+  while (v >= 0x80){
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+inline int64_t readVarint(const uint8_t*& p, const uint8_t* end){
+  uint64_t v = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7){
+    uint8_t b = *p++;
+    v |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80)) break;
+  }
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+inline uint32_t floatBits(float f){ uint32_t u; std::memcpy(&u, &f, 4); return u; }
+inline float bitsFloat(uint32_t u){ float f; std::memcpy(&f, &u, 4); return f; }
+
+} // namespace Trajectory
+
+// Appends one frame per record() call. Chunks are encoded on the calling thread into reused buffers and
+// written by a background thread, so the frame never waits on the disk.
+class TrajectoryRecorder {
+  public:
+  ~TrajectoryRecorder(){ stop(); }
+
+  bool recording() const { return file != nullptr; }
+  uint64_t frames() const { return tick; }
+
+  bool start(const char* path, uint16_t keyframeInterval = 120){
+    stop();
+    file = std::fopen(path, "wb");
+    if (!file) return false;
+    interval = std::max<uint16_t>(1, keyframeInterval);
+    tick = 0;
+    time = 0;
+    inChunk = 0;
+    uuids.clear();
+    std::vector<uint8_t> header;
+    header.insert(header.end(), Trajectory::Magic, Trajectory::Magic + 4);
+    Trajectory::append<uint16_t>(header, Trajectory::Version);
+    Trajectory::append<uint16_t>(header, interval);
+    std::fwrite(header.data(), 1, header.size(), file);
+#ifndef __EMSCRIPTEN__
+    quit = false;
+    writer = std::thread([this]{ writerLoop(); });
+#endif
+    return true;
+  }
+
+  void stop(){
+    if (!file) return;
+    if (inChunk > 0) finishChunk();
+#ifndef __EMSCRIPTEN__
+    {
+      std::lock_guard<std::mutex> lock(m);
+      quit = true;
+    }
+    wake.notify_all();
+    writer.join();
+#endif
+    std::fclose(file);
+    file = nullptr;
+  }
+
+  // dt is the simulation time since the previous frame
+  void record(double dt){
+    if (!file) return;
+    time += dt;
+    if (inChunk == 0) beginChunk();
+    if (inChunk == 0 || !sameBodies()) writeKeyframe();
+    else writeDelta();
+    ++inChunk;
+    ++tick;
+    if (inChunk >= interval) finishChunk();
+  }
+
+  private:
+  std::FILE* file = nullptr;
+  uint16_t interval = 120;
+  uint64_t tick = 0;
+  double time = 0;
+  uint32_t inChunk = 0;
+  std::vector<uint8_t> current;
+  std::vector<uint64_t> uuids;  // bodies of the last frame, in slot order
+  std::vector<uint32_t> bits;   // their pos/speed bit patterns, 4 per body
+  std::vector<int64_t> steps;   // last change of each bit pattern
+
+  std::vector<std::vector<uint8_t>> spare;
+#ifndef __EMSCRIPTEN__
+  std::deque<std::vector<uint8_t>> pending;
+  std::thread writer;
+  std::mutex m;
+  std::condition_variable wake;
+  bool quit = false;
+#endif
+
+  void beginChunk(){
+    current.clear();
+    current.insert(current.end(), Trajectory::ChunkMagic, Trajectory::ChunkMagic + 4);
+    Trajectory::append<uint32_t>(current, 0); // payload bytes, patched by finishChunk
+    Trajectory::append<uint32_t>(current, 0); // frames, patched by finishChunk
+    Trajectory::append<uint64_t>(current, tick);
+  }
+
+  void finishChunk(){
+    uint8_t* p = current.data() + 4;
+    Snapshot::put<uint32_t>(p, (uint32_t)(current.size() - Trajectory::ChunkHeaderSize));
+    Snapshot::put<uint32_t>(p, inChunk);
+    inChunk = 0;
+#ifdef __EMSCRIPTEN__
+    std::fwrite(current.data(), 1, current.size(), file);
+#else
+    std::vector<uint8_t> next;
+    {
+      std::lock_guard<std::mutex> lock(m);
+      pending.push_back(std::move(current));
+      if (!spare.empty()){
+        next = std::move(spare.back());
+        spare.pop_back();
+      }
+    }
+    wake.notify_one();
+    current = std::move(next);
+#endif
+  }
+
+  bool sameBodies() const {
+    size_t k = 0;
+    for (size_t j = 0; j < bodies.size(); ++j){
+      if (bodies.flags[j].shouldRemove) continue;
+      if (k >= uuids.size() || bodies.handle[j]->uuid != uuids[k]) return false;
+      ++k;
+    }
+    return k == uuids.size();
+  }
+
+  void writeKeyframe(){
+    using namespace Trajectory;
+    current.push_back(Keyframe);
+    append<double>(current, time);
+    uint32_t count = 0;
+    for (size_t j = 0; j < bodies.size(); ++j) count += !bodies.flags[j].shouldRemove;
+    append<uint32_t>(current, count);
+    uuids.clear();
+    bits.clear();
+    steps.clear();
+    for (size_t j = 0; j < bodies.size(); ++j){
+      if (bodies.flags[j].shouldRemove) continue;
+      Object* o = bodies.handle[j];
+      append<uint64_t>(current, o->uuid);
+      current.push_back((uint8_t)bodies.shape[j]);
+      current.push_back(o->color.r);
+      current.push_back(o->color.g);
+      current.push_back(o->color.b);
+      bool circle = bodies.shape[j] == Shape::Circle;
+      append<float>(current, circle ? (float)bodies.radius[j] : bodies.sides[j].x);
+      append<float>(current, circle ? (float)bodies.radius[j] : bodies.sides[j].y);
+      const float v[4] = {bodies.pos[j].x, bodies.pos[j].y, bodies.speed[j].x, bodies.speed[j].y};
+      for (float f : v){
+        append<float>(current, f);
+        bits.push_back(floatBits(f));
+        steps.push_back(0);
+      }
+      uuids.push_back(o->uuid);
+    }
+  }
+
+  void writeDelta(){
+    using namespace Trajectory;
+    current.push_back(Delta);
+    append<double>(current, time);
+    size_t k = 0;
+    for (size_t j = 0; j < bodies.size(); ++j){
+      if (bodies.flags[j].shouldRemove) continue;
+      const float v[4] = {bodies.pos[j].x, bodies.pos[j].y, bodies.speed[j].x, bodies.speed[j].y};
+      for (float f : v){
+        uint32_t b = floatBits(f);
+        int64_t step = (int64_t)b - (int64_t)bits[k];
+        appendVarint(current, step - steps[k]);
+        steps[k] = step;
+        bits[k++] = b;
+      }
+    }
+  }
+
+#ifndef __EMSCRIPTEN__
+  void writerLoop(){
+    for (;;){
+      std::vector<uint8_t> chunk;
+      {
+        std::unique_lock<std::mutex> lock(m);
+        wake.wait(lock, [this]{ return quit || !pending.empty(); });
+        if (pending.empty()) return;
+        chunk = std::move(pending.front());
+        pending.pop_front();
+      }
+      std::fwrite(chunk.data(), 1, chunk.size(), file);
+      std::lock_guard<std::mutex> lock(m);
+      spare.push_back(std::move(chunk));
+    }
+  }
+#endif
+};
+
+// Plays a trajectory file back without running physics: decodes frames into its own arrays and draws them.
+class TrajectoryReplay {
+  public:
+  bool active() const { return file != nullptr; }
+  uint64_t frames() const { return total; }
+  uint64_t frame() const { return current; }
+  double time() const { return frameTime; }
+
+  bool open(const char* path){
+    close();
+    file.reset(new Snapshot::MappedFile(path));
+    const uint8_t* p = file->data();
+    const uint8_t* end = p + file->size();
+    if (file->size() < Trajectory::HeaderSize || std::memcmp(p, Trajectory::Magic, 4) != 0){
+      file.reset();
+      return false;
+    }
+    // chunk index; a truncated last chunk (recording cut short) is dropped
+    p += Trajectory::HeaderSize;
+    while (end - p >= (ptrdiff_t)Trajectory::ChunkHeaderSize && std::memcmp(p, Trajectory::ChunkMagic, 4) == 0){
+      const uint8_t* q = p + 4;
+      Chunk c;
+      c.size = Snapshot::get<uint32_t>(q);
+      c.frames = Snapshot::get<uint32_t>(q);
+      c.first = Snapshot::get<uint64_t>(q);
+      c.data = q;
+      if ((size_t)(end - q) < c.size || c.frames == 0) break;
+      chunks.push_back(c);
+      p = q + c.size;
+    }
+    if (chunks.empty()){
+      close();
+      return false;
+    }
+    total = chunks.back().first + chunks.back().frames;
+    seek(0);
+    return true;
+  }
+
+  void close(){
+    file.reset();
+    chunks.clear();
+    total = current = 0;
+    uuid.clear(); shape.clear(); color.clear(); size.clear(); bits.clear(); steps.clear();
+  }
+
+  // decodes from the keyframe that starts the chunk holding the frame
+  void seek(int64_t target){
+    if (!active()) return;
+    target = std::clamp<int64_t>(target, 0, (int64_t)total - 1);
+    chunk = 0;
+    while (chunk + 1 < chunks.size() && chunks[chunk + 1].first <= (uint64_t)target) ++chunk;
+    cursor = chunks[chunk].data;
+    current = chunks[chunk].first;
+    decodeFrame();
+    while (current < (uint64_t)target){
+      ++current;
+      decodeFrame();
+    }
+  }
+
+  void advance(int64_t frames = 1){
+    if (!active()) return;
+    const Chunk& c = chunks[chunk];
+    if (frames == 1 && current + 1 < c.first + c.frames){
+      ++current;
+      decodeFrame();
+    }
+    else seek((int64_t)current + frames);
+  }
+
+  void draw() const {
+    const float scale = (float)(visualScale() / windowScale);
+    for (size_t j = 0; j < uuid.size(); ++j){
+      Vector2 p = vector(Trajectory::bitsFloat(bits[4 * j]), Trajectory::bitsFloat(bits[4 * j + 1]));
+      Vector2 s = (p - windowPos) / windowScale;
+      if (shape[j] == Shape::Circle){
+        float r = size[j].x * scale;
+        if (shapeBatch.visibleCircle(s, r)) shapeBatch.circle(s, r, color[j]);
+      } else {
+        Rectangle r;
+        r.width = size[j].x / windowScale;
+        r.height = size[j].y / windowScale;
+        r.x = s.x * visualScale() - r.width / 2;
+        r.y = s.y * visualScale() - r.height / 2;
+        if (shapeBatch.visibleRect(r)) shapeBatch.rect(r, color[j]);
+      }
+    }
+    shapeBatch.end();
+  }
+
+  private:
+  struct Chunk {
+    const uint8_t* data;
+    uint32_t size, frames;
+    uint64_t first;
+  };
+  std::unique_ptr<Snapshot::MappedFile> file;
+  std::vector<Chunk> chunks;
+  uint64_t total = 0, current = 0;
+  size_t chunk = 0;
+  const uint8_t* cursor = nullptr;
+  double frameTime = 0;
+  // decoded state of the current frame
+  std::vector<uint64_t> uuid;
+  std::vector<Shape> shape;
+  std::vector<Color> color;
+  std::vector<Vector2> size;
+  std::vector<uint32_t> bits; // pos/speed bit patterns, 4 per body
+  std::vector<int64_t> steps; // last change of each bit pattern
+
+  void decodeFrame(){
+    using namespace Trajectory;
+    const uint8_t* p = cursor;
+    const uint8_t* end = chunks[chunk].data + chunks[chunk].size;
+    if (end - p < 9) return;
+    uint8_t type = *p++;
+    frameTime = Snapshot::get<double>(p);
+    if (type == Keyframe){
+      if (end - p < 4) return;
+      uint32_t count = Snapshot::get<uint32_t>(p);
+      if ((size_t)(end - p) / 36 < count) return;
+      uuid.resize(count); shape.resize(count); color.resize(count); size.resize(count);
+      bits.resize(4 * (size_t)count);
+      steps.assign(4 * (size_t)count, 0);
+      for (uint32_t j = 0; j < count; ++j){
+        uuid[j] = Snapshot::get<uint64_t>(p);
+        shape[j] = (Shape)*p++;
+        color[j] = {p[0], p[1], p[2], 255};
+        p += 3;
+        size[j].x = Snapshot::get<float>(p);
+        size[j].y = Snapshot::get<float>(p);
+        for (int k = 0; k < 4; ++k) bits[4 * j + k] = floatBits(Snapshot::get<float>(p));
+      }
+    } else {
+      for (size_t k = 0; k < bits.size(); ++k){
+        steps[k] += readVarint(p, end);
+        bits[k] = (uint32_t)((int64_t)bits[k] + steps[k]);
+      }
+    }
+    cursor = p;
+  }
+};
+
+TrajectoryRecorder recorder;
+TrajectoryReplay replay;
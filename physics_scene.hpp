@@ -0,0 +1,369 @@
+#pragma once
+#include "physics_engine.hpp"
+#include "physics_world.hpp"
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <atomic>
+#include <cstdio>
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#endif
+
+// ---------------- CSV scene save/load ----------------
+// An optional first line "# integrator=<name> substep=<seconds>" carries the stepping settings;
+// files without it load with the defaults (semi-implicit Euler, 1/240 s).
+void ClearScene() {
+    bodies.clear();
+    particles.clear();
+}
+
+// Plain copy of everything a CSV row needs, so formatting can run off the main thread
+struct SceneRow {
+    double width, height; // width 0 => circle of diameter height
+    Vector2 pos, speed;
+    double mass, friction;
+    float elasticity;
+    BodyFlags flags;
+    Color color;
+};
+
+struct SceneCapture {
+    Integrator integrator = Integrator::SemiImplicitEuler;
+    double fixedDt = 0;
+    std::vector<SceneRow> rows;
+};
+
+// Row for body slot j; false for removed bodies and unknown shapes
+bool CaptureRow(size_t j, SceneRow& r) {
+    if (bodies.flags[j].shouldRemove) return false;
+    switch (bodies.shape[j]) {
+    case Shape::Circle:
+        r.width  = 0.0; // circle flag
+        r.height = bodies.radius[j] * 2.0; // radius = Height/2
+        break;
+    case Shape::Rectangle:
+        r.width  = bodies.sides[j].x;
+        r.height = bodies.sides[j].y;
+        break;
+    default:
+        return false; // unknown type – skip
+    }
+    r.pos = bodies.pos[j];
+    r.speed = bodies.speed[j];
+    r.mass = bodies.mass[j];
+    r.friction = bodies.frictionFactor[j];
+    r.elasticity = bodies.elasticity[j];
+    r.flags = bodies.flags[j];
+    r.color = bodies.handle[j]->color;
+    return true;
+}
+
+// O(N) copy out of the body arrays; reuses out.rows' capacity
+void CaptureScene(SceneCapture& out) {
+    out.integrator = integrator;
+    out.fixedDt = world.fixedDt;
+    out.rows.clear();
+    out.rows.reserve(bodies.size());
+    SceneRow r;
+    for (size_t j = 0; j < bodies.size(); ++j)
+        if (CaptureRow(j, r)) out.rows.push_back(r);
+}
+
+// Formats a capture as CSV; bumps *written every few thousand rows if given
+bool WriteSceneCSV(const SceneCapture& scene, const char* path, std::atomic<size_t>* written = nullptr) {
+    std::ofstream ofs(path);
+    if (!ofs) return false;
+
+    ofs << "# integrator=" << integratorNames[(int)scene.integrator] << " substep=" << scene.fixedDt << '\n';
+    // Header:
+    ofs << "Width,Height,Pos_X,Pos_Y,Speed_X,Speed_Y,Mass,Friction,Elasticity,"
+           "GravityAffected,LeaveTrail,Fixed,Color_R,Color_G,Color_B\n";
+
+    size_t n = 0;
+    for (const SceneRow& r : scene.rows) {
+        ofs << r.width << ','
+            << r.height << ','
+            << r.pos.x << ','
+            << r.pos.y << ','
+            << r.speed.x << ','
+            << r.speed.y << ','
+            << r.mass << ','
+            << r.friction << ','
+            << r.elasticity << ','
+            << (r.flags.gravityAffected ? 1 : 0) << ','
+            << (r.flags.leaveTrail ? 1 : 0) << ','
+            << (r.flags.fixed ? 1 : 0) << ','
+            << (int)r.color.r << ','
+            << (int)r.color.g << ','
+            << (int)r.color.b << '\n';
+        if (written && ++n % 4096 == 0) written->store(n, std::memory_order_relaxed);
+    }
+    if (written) written->store(scene.rows.size(), std::memory_order_relaxed);
+    ofs.close();
+    return !ofs.fail();
+}
+
+void SaveSceneCSV(const char* path) {
+    SceneCapture scene;
+    CaptureScene(scene);
+    WriteSceneCSV(scene, path);
+}
+
+// Saves a scene without stalling the frame: start() copies an already captured scene (the render
+// thread passes the simulation's published view), a worker formats it into "<path>.tmp" and renames
+// it over <path> only once fully written, so a crash mid-save never leaves a truncated scene behind.
+// Web builds have no worker and write synchronously inside start().
+class AsyncSceneSaver {
+  public:
+  enum class Status { Idle, Writing, Done, Failed };
+
+  ~AsyncSceneSaver() { wait(); }
+
+  // false if the previous save is still being written
+  bool start(const std::string& path, const SceneCapture& scene) {
+    if (busy()) return false;
+    wait();
+    capture.integrator = scene.integrator;
+    capture.fixedDt = scene.fixedDt;
+    capture.rows.assign(scene.rows.begin(), scene.rows.end());
+    target = path;
+    total_ = capture.rows.size();
+    written_.store(0, std::memory_order_relaxed);
+    reported = false;
+    state.store(Status::Writing);
+#ifdef __EMSCRIPTEN__
+    run();
+#else
+    worker = std::thread([this]{ run(); });
+#endif
+    return true;
+  }
+
+  // Call once per frame on the main thread: true exactly once per save that finished since
+  bool poll() {
+    Status s = state.load();
+    if (s == Status::Writing || s == Status::Idle || reported) return false;
+    wait();
+    reported = true;
+    finishedAt = GetTime();
+    return s == Status::Done;
+  }
+
+  void wait() {
+#ifndef __EMSCRIPTEN__
+    if (worker.joinable()) worker.join();
+#endif
+  }
+
+  bool busy() const { return state.load() == Status::Writing; }
+  Status status() const { return state.load(); }
+  const std::string& path() const { return target; }
+  size_t written() const { return written_.load(std::memory_order_relaxed); }
+  size_t total() const { return total_; }
+  double secondsSinceFinished() const { return reported ? GetTime() - finishedAt : 0.0; }
+
+  private:
+  SceneCapture capture; // kept between saves so the rows buffer is allocated once
+  std::string target;
+  size_t total_ = 0;
+  std::atomic<size_t> written_{0};
+  std::atomic<Status> state{Status::Idle};
+  bool reported = false;
+  double finishedAt = 0;
+#ifndef __EMSCRIPTEN__
+  std::thread worker;
+#endif
+
+  void run() {
+    std::string tmp = target + ".tmp";
+    bool ok = WriteSceneCSV(capture, tmp.c_str(), &written_);
+#ifdef _WIN32
+    if (ok) std::remove(target.c_str()); // rename() won't replace an existing file here
+#endif
+    ok = ok && std::rename(tmp.c_str(), target.c_str()) == 0;
+    if (!ok) std::remove(tmp.c_str());
+    state.store(ok ? Status::Done : Status::Failed);
+  }
+};
+
+AsyncSceneSaver sceneSaver;
+
+// Result of LoadSceneCSV: malformed rows are skipped and reported instead of aborting the load
+struct SceneLoadReport {
+    bool opened = false;
+    size_t rows = 0;           // bodies created
+    size_t errorCount = 0;     // rows skipped
+    struct Error { size_t line; std::string message; };
+    std::vector<Error> errors; // the first maxErrors of them
+    static const size_t maxErrors = 32;
+
+    void fail(size_t line, std::string message) {
+        ++errorCount;
+        if (errors.size() < maxErrors) errors.push_back({line, std::move(message)});
+    }
+};
+
+namespace SceneCSV {
+
+// columns the loader understands; any other header column is ignored
+enum Column { Width, Height, PosX, PosY, SpeedX, SpeedY, Mass, Friction, Elasticity,
+              GravityAffected, LeaveTrail, Fixed, ColorR, ColorG, ColorB, ColumnCount };
+const char* columnNames[ColumnCount] = {"Width", "Height", "Pos_X", "Pos_Y", "Speed_X", "Speed_Y", "Mass",
+    "Friction", "Elasticity", "GravityAffected", "LeaveTrail", "Fixed", "Color_R", "Color_G", "Color_B"};
+
+inline std::string_view trim(std::string_view v) {
+    while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back() == ' ' || v.back() == '\t' || v.back() == '\r')) v.remove_suffix(1);
+    return v;
+}
+
+// empty cells read as 0 like they always did; false only for text that isn't a number
+inline bool parseNumber(std::string_view cell, double& out) {
+    cell = trim(cell);
+    out = 0.0;
+    if (cell.empty()) return true;
+    if (cell.front() == '+') cell.remove_prefix(1);
+    // most cells are small integers (flags, colors, zeros)
+    if (cell.size() <= 9) {
+        bool neg = cell.front() == '-';
+        size_t k = neg ? 1 : 0;
+        long long n = 0;
+        while (k < cell.size() && cell[k] >= '0' && cell[k] <= '9') n = n * 10 + (cell[k++] - '0');
+        if (k == cell.size() && k > (neg ? 1u : 0u)) {
+            out = (double)(neg ? -n : n);
+            return true;
+        }
+    }
+    auto r = std::from_chars(cell.data(), cell.data() + cell.size(), out);
+    return r.ec == std::errc() && r.ptr == cell.data() + cell.size();
+}
+
+// calls fn(cell) for each comma separated cell of the line
+template<class F>
+inline void forEachCell(std::string_view line, F&& fn) {
+    size_t start = 0;
+    for (;;) {
+        size_t comma = line.find(',', start);
+        fn(line.substr(start, comma == std::string_view::npos ? std::string_view::npos : comma - start));
+        if (comma == std::string_view::npos) return;
+        start = comma + 1;
+    }
+}
+
+} // namespace SceneCSV
+
+// Reads the whole file into one buffer and parses it in place with from_chars. Columns are matched by
+// header name, so files with extra or reordered columns load; without a recognisable header row the
+// fixed 15-column order above is assumed.
+SceneLoadReport LoadSceneCSV(const char* path) {
+    using namespace SceneCSV;
+    SceneLoadReport report;
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) return report;
+    report.opened = true;
+    std::string text;
+    ifs.seekg(0, std::ios::end);
+    text.resize((size_t)std::max<std::streamoff>(0, ifs.tellg()));
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(&text[0], (std::streamsize)text.size());
+    text.resize((size_t)ifs.gcount());
+
+    ClearScene();
+    integrator = Integrator::SemiImplicitEuler;
+    world.reset();
+    bodies.reserve((size_t)std::count(text.begin(), text.end(), '\n') + 1);
+
+    // cell position -> known column (-1 = ignored), the fixed order until a header row says otherwise
+    const size_t maxCells = 64;
+    int cellColumn[maxCells];
+    size_t cells = ColumnCount;
+    for (int k = 0; k < ColumnCount; ++k) cellColumn[k] = k;
+    bool firstRow = true;
+
+    std::string_view rest(text);
+    size_t lineNo = 0;
+
+    while (!rest.empty()) {
+        size_t nl = rest.find('\n');
+        std::string_view line = trim(rest.substr(0, nl));
+        rest = nl == std::string_view::npos ? std::string_view() : rest.substr(nl + 1);
+        ++lineNo;
+        if (line.empty()) continue;
+
+        if (line.front() == '#') {
+            // "# integrator=<name> substep=<seconds>"
+            std::string_view settings = line.substr(1);
+            while (!settings.empty()) {
+                size_t sp = settings.find(' ');
+                std::string_view kv = settings.substr(0, sp);
+                settings = sp == std::string_view::npos ? std::string_view() : settings.substr(sp + 1);
+                size_t eq = kv.find('=');
+                if (eq == std::string_view::npos) continue;
+                std::string_view key = kv.substr(0, eq), value = kv.substr(eq + 1);
+                double substep;
+                if (key == "integrator") ParseIntegrator(std::string(value), integrator);
+                else if (key == "substep" && parseNumber(value, substep) && substep > 0) world.fixedDt = substep;
+            }
+            continue;
+        }
+
+        if (firstRow) {
+            firstRow = false;
+            char c0 = line.front();
+            if ((c0 >= 'A' && c0 <= 'Z') || (c0 >= 'a' && c0 <= 'z')) {
+                bool used[ColumnCount] = {};
+                cells = 0;
+                forEachCell(line, [&](std::string_view cell) {
+                    if (cells == maxCells) return;
+                    int& column = cellColumn[cells++];
+                    column = -1;
+                    cell = trim(cell);
+                    for (int c = 0; c < ColumnCount; ++c) {
+                        if (!used[c] && cell == columnNames[c]) { column = c; used[c] = true; break; }
+                    }
+                });
+                continue;
+            }
+        }
+
+        double v[ColumnCount] = {};
+        size_t k = 0;
+        int bad = -1;
+        forEachCell(line, [&](std::string_view cell) {
+            if (k < cells && cellColumn[k] >= 0 && bad < 0 && !parseNumber(cell, v[cellColumn[k]]))
+                bad = (int)k;
+            ++k;
+        });
+        if (bad >= 0) {
+            report.fail(lineNo, "column " + std::to_string(bad + 1) + ": not a number");
+            continue;
+        }
+
+        Color color = {(unsigned char)std::clamp(v[ColorR], 0.0, 255.0), (unsigned char)std::clamp(v[ColorG], 0.0, 255.0),
+                       (unsigned char)std::clamp(v[ColorB], 0.0, 255.0), 255};
+        Vector2 pos = vector(v[PosX], v[PosY]);
+        Vector2 vel = vector(v[SpeedX], v[SpeedY]);
+        bool trail = v[LeaveTrail] != 0;
+
+        Object* o = nullptr;
+
+        if (v[Width] == 0.0) {
+            double radius = v[Height] * 0.5;
+            o = bodies.spawn<PhysicsCircularObject>(pos, vel, color, v[Mass], radius, v[Friction], trail);
+        } else {
+            Vector2 sides = vector(v[Width], v[Height]);
+            o = bodies.spawn<PhysicsRectangularObject>(pos, vel, color, v[Mass], sides, v[Friction]);
+            o->leaveTrail() = trail;
+        }
+
+        o->elasticity()      = (float)v[Elasticity];
+        o->gravityAffected() = (v[GravityAffected] != 0);
+        o->fixed()           = (v[Fixed] != 0);
+        ++report.rows;
+    }
+    return report;
+}
@@ -0,0 +1,300 @@
+#pragma once
+#include "physics_engine.hpp"
+#include "physics_world.hpp"
+#include "physics_scene.hpp"
+#include "physics_recorder.hpp"
+#include "physics_batch.hpp"
+#include "physics_profiler.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#endif
+
+// ---------------- simulation thread ----------------
+// The simulation owns bodies, particles, world and the settings they read (solver, integrator,
+// trail lifetime, recorder) and runs on its own thread at simulationRate. The render thread never
+// touches any of that: it draws and inspects the latest SimView, and everything that changes the
+// simulation (editor edits, clicks, key toggles, loads) is posted as a command that runs on the
+// simulation thread between ticks.
+
+// Extent of a row, as picking and the selection outline see it
+Broadphase::Box RowBox(const SceneRow& row){
+  const double hw = row.width == 0 ? row.height / 2 : row.width / 2;
+  const double hh = row.height / 2;
+  return {row.pos.x - hw, row.pos.y - hh, row.pos.x + hw, row.pos.y + hh};
+}
+
+// One published copy of the simulation state
+struct SimView {
+  SceneCapture scene;            // exact body state in slot order, also what async saves write
+  std::vector<uint64_t> uuid;    // per row; commands address bodies by uuid, never by pointer
+  std::vector<Vector2> drawPos;  // per row, interpolated between the last two substeps
+  std::vector<Vector2> particlePos;
+  std::vector<float> particleRadius;
+  std::vector<Color> particleColor;
+  // simulation-owned settings and counters, for the UI
+  GravitySolver gravitySolver = GravitySolver::BarnesHut;
+  double barnesHutTheta = 0.5;
+  int fmmOrder = 6;
+  double trailLifetime = 0;
+  size_t candidatePairs = 0, prunedPairs = 0;
+  bool recording = false;
+  uint64_t recordedFrames = 0;
+  double tickRate = 0; // measured simulation ticks per second
+  // editor picking: box tree over the rows of bodies with mass; tree index i is row pickRows[i]
+  Broadphase::BoxTree pickTree;
+  std::vector<int> pickRows;
+
+  // fills the view from the engine globals; simulation thread only
+  void capture(){
+    scene.integrator = integrator;
+    scene.fixedDt = world.fixedDt;
+    scene.rows.clear();
+    uuid.clear();
+    drawPos.clear();
+    const float alpha = (float)renderAlpha;
+    SceneRow r;
+    for (size_t j = 0; j < bodies.size(); ++j){
+      if (!CaptureRow(j, r)) continue;
+      Vector2 p = r.pos;
+      if (r.flags.simulated) p = bodies.prevPos[j] + (p - bodies.prevPos[j]) * alpha;
+      scene.rows.push_back(r);
+      uuid.push_back(bodies.handle[j]->uuid);
+      drawPos.push_back(p);
+    }
+    capturePicking();
+    particles.capture(particlePos, particleRadius, particleColor);
+    gravitySolver = ::gravitySolver;
+    barnesHutTheta = ::barnesHutTheta;
+    fmmOrder = ::fmmOrder;
+    trailLifetime = ::trailLifetime;
+    candidatePairs = broadphase.candidatePairs;
+    prunedPairs = broadphase.prunedPairs;
+    recording = recorder.recording();
+    recordedFrames = recorder.frames();
+  }
+
+  // The tree belongs to this view slot and is kept from one capture to the next: while the slot sees
+  // the same massive bodies it is only refitted, O(N), and it is rebuilt when they change or every
+  // PickRebuildInterval captures so the Morton order doesn't go stale as bodies move.
+  static const int PickRebuildInterval = 64;
+  std::vector<uint64_t> pickIds;
+  std::vector<Broadphase::Box> pickBoxes;
+  int pickRefits = 0;
+
+  void capturePicking(){
+    pickRows.clear();
+    pickBoxes.clear();
+    bool same = true;
+    for (size_t k = 0; k < scene.rows.size(); ++k){
+      if (!(scene.rows[k].mass > 0)) continue;
+      if (pickRows.size() >= pickIds.size() || pickIds[pickRows.size()] != uuid[k]) same = false;
+      pickRows.push_back((int)k);
+      pickBoxes.push_back(RowBox(scene.rows[k]));
+    }
+    if (same && pickRows.size() == pickIds.size() && ++pickRefits < PickRebuildInterval){
+      pickTree.refit(pickBoxes);
+      return;
+    }
+    pickTree.build(pickBoxes);
+    pickIds.resize(pickRows.size());
+    for (size_t i = 0; i < pickRows.size(); ++i) pickIds[i] = uuid[pickRows[i]];
+    pickRefits = 0;
+  }
+
+  // row index of the body with this uuid, or -1
+  long find(uint64_t id) const {
+    for (size_t k = 0; k < uuid.size(); ++k) if (uuid[k] == id) return (long)k;
+    return -1;
+  }
+};
+
+// Live body by uuid, for commands; nullptr once it has been removed
+Object* FindBody(uint64_t id){
+  for (size_t j = 0; j < bodies.size(); ++j)
+    if (bodies.handle[j]->uuid == id && !bodies.flags[j].shouldRemove) return bodies.handle[j];
+  return nullptr;
+}
+
+// Draws a view through shapeBatch, with bodies outside the viewport culled before their colour is read.
+// Circles are scaled by visualScale(); rectangles keep their size, only their position is scaled.
+void DrawView(const SimView& v){
+  const float inv = (float)(1.0 / windowScale);
+  const float circleScale = (float)(visualScale() / windowScale);
+  const float rectScale = (float)visualScale();
+  for (size_t k = 0; k < v.particlePos.size(); ++k){
+    Vector2 s = (v.particlePos[k] - windowPos) * inv;
+    float r = v.particleRadius[k] * circleScale;
+    if (shapeBatch.visibleCircle(s, r)) shapeBatch.circle(s, r, v.particleColor[k]);
+  }
+  const std::vector<SceneRow>& rows = v.scene.rows;
+  for (size_t k = 0; k < rows.size(); ++k){
+    Vector2 s = (v.drawPos[k] - windowPos) * inv;
+    if (rows[k].width == 0){
+      float r = (float)rows[k].height * 0.5f * circleScale;
+      if (shapeBatch.visibleCircle(s, r)) shapeBatch.circle(s, r, rows[k].color);
+    } else {
+      Rectangle r;
+      r.width = (float)rows[k].width * inv;
+      r.height = (float)rows[k].height * inv;
+      r.x = s.x * rectScale - r.width / 2;
+      r.y = s.y * rectScale - r.height / 2;
+      if (shapeBatch.visibleRect(r)) shapeBatch.rect(r, rows[k].color);
+    }
+  }
+  shapeBatch.end();
+}
+
+// Runs the simulation and hands views to the render thread through a triple buffer: the simulation
+// fills its back view and swaps it into `ready`, the renderer swaps its front view out of `ready`,
+// both with one atomic exchange, so neither side ever waits for the other. A new view is only built
+// once the renderer has taken the previous one, which keeps copying at the frame rate rather than
+// the tick rate. Web builds have no thread; the main loop calls tick() once per frame instead.
+class SimThread {
+  public:
+  using Command = std::function<void()>;
+
+  ~SimThread(){ stop(); }
+
+  void start(){
+#ifndef __EMSCRIPTEN__
+    if (worker.joinable()) return;
+    quit.store(false);
+    worker = std::thread([this]{ loop(); });
+#endif
+  }
+
+  void stop(){
+#ifndef __EMSCRIPTEN__
+    quit.store(true);
+    if (worker.joinable()) worker.join();
+#endif
+  }
+
+  // any thread; runs on the simulation thread before its next tick, in posting order
+  void post(Command c){
+    std::lock_guard<std::mutex> lock(commandsLock);
+    commands.push_back(std::move(c));
+  }
+
+  // render thread, once per frame: sim time advances by real time * timeScale unless paused
+  void setClock(bool isPaused, double scale){
+    pausedFlag.store(isPaused, std::memory_order_relaxed);
+    timeScaleValue.store(scale, std::memory_order_relaxed);
+  }
+
+  // render thread: the newest published view, stable until the next acquire()
+  const SimView& acquire(){
+    if (ready.load(std::memory_order_acquire) & Fresh)
+      front = ready.exchange(front, std::memory_order_acq_rel) & IndexMask;
+    return views[front];
+  }
+  const SimView& view() const { return views[front]; }
+
+  // one simulation tick; dt is real time since the previous one
+  void tick(double dt){
+    Profiler::Scope zone(Profiler::Phase::Tick);
+    bool changed = runCommands();
+    bodies.removeMarked();
+    if (!pausedFlag.load(std::memory_order_relaxed)){
+      const double ft = dt * timeScaleValue.load(std::memory_order_relaxed);
+      world.step(ft);
+      {
+        Profiler::Scope zone(Profiler::Phase::Particles);
+        particles.update(ft);
+      }
+      // bodies created during the pass are ticked in the same tick
+      Profiler::Scope bodiesZone(Profiler::Phase::Bodies);
+      ++world.ticks;
+      for (size_t j = 0; j < bodies.size(); ++j){
+        if (bodies.flags[j].shouldRemove) continue;
+        bodies.handle[j]->tick(ft);
+      }
+      unrecorded += ft;
+      changed = true;
+    }
+    rateTicks++;
+    rateTime += dt;
+    if (rateTime >= 0.5){
+      tickRate = rateTicks / rateTime;
+      rateTicks = 0;
+      rateTime = 0;
+    }
+    dirty = dirty || changed;
+    if (dirty && !(ready.load(std::memory_order_acquire) & Fresh)) publish();
+  }
+
+  private:
+  static constexpr int IndexMask = 3;
+  static constexpr int Fresh = 4; // set while `ready` holds a view the renderer hasn't taken
+
+  SimView views[3];
+  std::atomic<int> ready{1};
+  int back = 0;  // simulation thread
+  int front = 2; // render thread
+  bool dirty = true;
+
+  std::mutex commandsLock;
+  std::vector<Command> commands;
+  std::vector<Command> running;
+
+  std::atomic<bool> pausedFlag{true};
+  std::atomic<double> timeScaleValue{1};
+  double unrecorded = 0; // sim time since the last recorded frame
+  double tickRate = 0;
+  double rateTime = 0;
+  int rateTicks = 0;
+
+#ifndef __EMSCRIPTEN__
+  std::thread worker;
+  std::atomic<bool> quit{false};
+
+  void loop(){
+    Profiler::setThreadName("simulation");
+    using clock = std::chrono::steady_clock;
+    auto last = clock::now();
+    auto next = last;
+    while (!quit.load()){
+      auto now = clock::now();
+      tick(std::chrono::duration<double>(now - last).count());
+      last = now;
+      next += std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / simulationRate));
+      if (next < now) next = now; // fell behind: carry on from here rather than bursting to catch up
+      std::this_thread::sleep_until(next);
+    }
+  }
+#endif
+
+  bool runCommands(){
+    {
+      std::lock_guard<std::mutex> lock(commandsLock);
+      running.swap(commands);
+    }
+    if (running.empty()) return false;
+    Profiler::Scope zone(Profiler::Phase::Commands);
+    for (auto& c : running) c();
+    running.clear();
+    return true;
+  }
+
+  void publish(){
+    Profiler::Scope zone(Profiler::Phase::Publish);
+    // one recorded frame per published view, so recordings follow the frame rate
+    if (unrecorded > 0){
+      recorder.record(unrecorded);
+      unrecorded = 0;
+    }
+    SimView& v = views[back];
+    v.capture();
+    v.tickRate = tickRate;
+    back = ready.exchange(back | Fresh, std::memory_order_acq_rel) & IndexMask;
+    dirty = false;
+  }
+};
+
+SimThread sim;
@@ -0,0 +1,324 @@
+#pragma once
+#include "physics_engine.hpp"
+#include "physics_world.hpp"
+#include "physics_scene.hpp"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ---------------- binary scene snapshots ----------------
+// Versioned little-endian format for large scenes; CSV stays the interchange format.
+//   header  (40 bytes)  "PHYS", u16 version, u16 flags, u32 integrator, u32 reserved, f64 substep, u64 count,
+//                       u64 payload bytes
+//   payload             count records of 64 bytes (layout in Snapshot::packRecord); with FlagCompressed each
+//                       record is XORed with the previous one and the result run-length coded (see compress)
+// Records hold the CSV columns at full precision plus the shape tag.
+namespace Snapshot {
+
+const char Magic[4] = {'P', 'H', 'Y', 'S'};
+const uint16_t Version = 1;
+const uint16_t FlagCompressed = 1;
+const size_t HeaderSize = 40;
+const size_t RecordSize = 64;
+
+// ---- little-endian field access ----
+template<class T>
+inline void put(uint8_t*& p, T v){
+  static_assert(sizeof(T) <= 8, "scalar fields only");
+  uint8_t b[sizeof(T)];
+  std::memcpy(b, &v, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (size_t k = 0; k < sizeof(T) / 2; ++k) std::swap(b[k], b[sizeof(T) - 1 - k]);
+#endif
+  std::memcpy(p, b, sizeof(T));
+  p += sizeof(T);
+}
+template<class T>
+inline T get(const uint8_t*& p){
+  uint8_t b[sizeof(T)];
+  std::memcpy(b, p, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (size_t k = 0; k < sizeof(T) / 2; ++k) std::swap(b[k], b[sizeof(T) - 1 - k]);
+#endif
+  T v;
+  std::memcpy(&v, b, sizeof(T));
+  p += sizeof(T);
+  return v;
+}
+
+// ---- records ----
+enum RecordFlags : uint8_t { GravityAffected = 1, LeaveTrail = 2, Fixed = 4 };
+
+// f64 mass, friction, radius | f32 pos x/y, speed x/y, sides x/y, elasticity | u8 shape, flags, r, g, b | pad
+inline void packRecord(size_t j, uint8_t* out){
+  uint8_t* p = out;
+  const BodyFlags& f = bodies.flags[j];
+  const Color& c = bodies.handle[j]->color;
+  put<double>(p, bodies.mass[j]);
+  put<double>(p, bodies.frictionFactor[j]);
+  put<double>(p, bodies.radius[j]);
+  put<float>(p, bodies.pos[j].x);     put<float>(p, bodies.pos[j].y);
+  put<float>(p, bodies.speed[j].x);   put<float>(p, bodies.speed[j].y);
+  put<float>(p, bodies.sides[j].x);   put<float>(p, bodies.sides[j].y);
+  put<float>(p, bodies.elasticity[j]);
+  put<uint8_t>(p, (uint8_t)bodies.shape[j]);
+  put<uint8_t>(p, (uint8_t)((f.gravityAffected ? GravityAffected : 0) | (f.leaveTrail ? LeaveTrail : 0) | (f.fixed ? Fixed : 0)));
+  put<uint8_t>(p, c.r); put<uint8_t>(p, c.g); put<uint8_t>(p, c.b);
+  std::memset(p, 0, RecordSize - (p - out));
+}
+
+// returns false for an unknown shape
+inline bool unpackRecord(const uint8_t* in){
+  const uint8_t* p = in;
+  double mass = get<double>(p), friction = get<double>(p), radius = get<double>(p);
+  Vector2 pos, speed, sides;
+  pos.x = get<float>(p);   pos.y = get<float>(p);
+  speed.x = get<float>(p); speed.y = get<float>(p);
+  sides.x = get<float>(p); sides.y = get<float>(p);
+  float elasticity = get<float>(p);
+  uint8_t shape = get<uint8_t>(p), flags = get<uint8_t>(p);
+  Color color;
+  color.r = get<uint8_t>(p); color.g = get<uint8_t>(p); color.b = get<uint8_t>(p); color.a = 255;
+
+  Object* o = nullptr;
+  switch ((Shape)shape){
+    case Shape::Circle:
+      o = bodies.spawn<PhysicsCircularObject>(pos, speed, color, mass, radius, friction, (flags & LeaveTrail) != 0);
+      break;
+    case Shape::Rectangle:
+      o = bodies.spawn<PhysicsRectangularObject>(pos, speed, color, mass, sides, friction);
+      o->leaveTrail() = (flags & LeaveTrail) != 0;
+      break;
+    default:
+      return false;
+  }
+  o->elasticity() = elasticity;
+  o->gravityAffected() = (flags & GravityAffected) != 0;
+  o->fixed() = (flags & Fixed) != 0;
+  return true;
+}
+
+// ---- compression: XOR with the previous record, then runs ----
+// control byte c < 128: c+1 literal bytes follow; c >= 128: c-127 zero bytes
+inline size_t compress(const uint8_t* delta, size_t n, uint8_t* out){
+  size_t w = 0, i = 0;
+  while (i < n){
+    size_t z = 0;
+    while (i + z < n && delta[i + z] == 0 && z < 128) ++z;
+    if (z >= 2 || (z == 1 && i + 1 == n)){
+      out[w++] = (uint8_t)(127 + z);
+      i += z;
+      continue;
+    }
+    size_t start = i, lit = 0;
+    // literals until the next pair of zeros
+    while (i < n && lit < 128 && !(delta[i] == 0 && i + 1 < n && delta[i + 1] == 0)){ ++i; ++lit; }
+    out[w++] = (uint8_t)(lit - 1);
+    std::memcpy(out + w, delta + start, lit);
+    w += lit;
+  }
+  return w;
+}
+
+// decodes exactly n bytes; returns the bytes consumed from in, 0 on malformed input
+inline size_t decompress(const uint8_t* in, size_t avail, uint8_t* delta, size_t n){
+  size_t r = 0, w = 0;
+  while (w < n){
+    if (r >= avail) return 0;
+    uint8_t c = in[r++];
+    if (c >= 128){
+      size_t z = c - 127;
+      if (w + z > n) return 0;
+      std::memset(delta + w, 0, z);
+      w += z;
+    } else {
+      size_t lit = (size_t)c + 1;
+      if (w + lit > n || r + lit > avail) return 0;
+      std::memcpy(delta + w, in + r, lit);
+      r += lit;
+      w += lit;
+    }
+  }
+  return r;
+}
+
+// ---- read-only file mapping (whole-file read where mmap is unavailable) ----
+class MappedFile {
+  public:
+  explicit MappedFile(const char* path){
+#if !defined(_WIN32)
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0){
+      void* p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED){
+        mapped = (const uint8_t*)p;
+        length = (size_t)st.st_size;
+      }
+    }
+    ::close(fd);
+    if (mapped) return;
+#endif
+    if (std::FILE* f = std::fopen(path, "rb")){
+      std::fseek(f, 0, SEEK_END);
+      long size = std::ftell(f);
+      std::fseek(f, 0, SEEK_SET);
+      if (size > 0){
+        copy.resize((size_t)size);
+        if (std::fread(copy.data(), 1, copy.size(), f) != copy.size()) copy.clear();
+      }
+      std::fclose(f);
+    }
+  }
+  ~MappedFile(){
+#if !defined(_WIN32)
+    if (mapped) ::munmap((void*)mapped, length);
+#endif
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* data() const { return mapped ? mapped : copy.data(); }
+  size_t size() const { return mapped ? length : copy.size(); }
+
+  private:
+  const uint8_t* mapped = nullptr;
+  size_t length = 0;
+  std::vector<uint8_t> copy;
+};
+
+} // namespace Snapshot
+
+bool IsSceneBinary(const char* path){
+  char magic[4] = {};
+  std::FILE* f = std::fopen(path, "rb");
+  if (!f) return false;
+  size_t got = std::fread(magic, 1, 4, f);
+  std::fclose(f);
+  return got == 4 && std::memcmp(magic, Snapshot::Magic, 4) == 0;
+}
+
+bool SaveSceneBinary(const char* path, bool compressed = false){
+  using namespace Snapshot;
+  std::FILE* f = std::fopen(path, "wb");
+  if (!f) return false;
+
+  uint64_t count = 0;
+  for (size_t j = 0; j < bodies.size(); ++j) count += !bodies.flags[j].shouldRemove;
+
+  uint8_t header[HeaderSize];
+  auto writeHeader = [&](uint64_t payload){
+    uint8_t* p = header;
+    std::memcpy(p, Magic, 4); p += 4;
+    put<uint16_t>(p, Version);
+    put<uint16_t>(p, compressed ? FlagCompressed : 0);
+    put<uint32_t>(p, (uint32_t)integrator);
+    put<uint32_t>(p, 0);
+    put<double>(p, world.fixedDt);
+    put<uint64_t>(p, count);
+    put<uint64_t>(p, payload);
+    return std::fwrite(header, 1, HeaderSize, f) == HeaderSize;
+  };
+  bool ok = writeHeader(compressed ? 0 : count * RecordSize);
+
+  // records are staged in a fixed block so large scenes go out in few writes
+  const size_t BlockRecords = 1024;
+  std::vector<uint8_t> block(BlockRecords * (RecordSize + RecordSize / 64 + 2));
+  uint8_t prev[RecordSize] = {}, rec[RecordSize], delta[RecordSize];
+  size_t used = 0;
+  uint64_t payload = 0;
+  for (size_t j = 0; j < bodies.size() && ok; ++j){
+    if (bodies.flags[j].shouldRemove) continue;
+    if (!compressed){
+      packRecord(j, block.data() + used);
+      used += RecordSize;
+    } else {
+      packRecord(j, rec);
+      for (size_t k = 0; k < RecordSize; ++k) delta[k] = rec[k] ^ prev[k];
+      std::memcpy(prev, rec, RecordSize);
+      used += compress(delta, RecordSize, block.data() + used);
+    }
+    if (used + RecordSize + RecordSize / 64 + 2 > block.size()){
+      ok = std::fwrite(block.data(), 1, used, f) == used;
+      payload += used;
+      used = 0;
+    }
+  }
+  if (ok && used){
+    ok = std::fwrite(block.data(), 1, used, f) == used;
+    payload += used;
+  }
+  if (ok && compressed){
+    std::fseek(f, 0, SEEK_SET);
+    ok = writeHeader(payload);
+  }
+  return std::fclose(f) == 0 && ok;
+}
+
+// Replaces the scene; on a malformed file the bodies read so far are kept and false is returned
+bool LoadSceneBinary(const char* path){
+  using namespace Snapshot;
+  MappedFile file(path);
+  const uint8_t* p = file.data();
+  if (file.size() < HeaderSize || std::memcmp(p, Magic, 4) != 0) return false;
+  p += 4;
+  uint16_t version = get<uint16_t>(p);
+  uint16_t flags = get<uint16_t>(p);
+  uint32_t integratorId = get<uint32_t>(p);
+  get<uint32_t>(p); // reserved
+  double substep = get<double>(p);
+  uint64_t count = get<uint64_t>(p);
+  uint64_t payload = get<uint64_t>(p);
+  if (version != Version || payload > file.size() - HeaderSize) return false;
+  // every record takes RecordSize bytes raw and at least one compressed; checked by division, since
+  // count * RecordSize can wrap
+  const uint64_t maxCount = flags & FlagCompressed ? payload : payload / RecordSize;
+  if (count > maxCount) return false;
+
+  ClearScene();
+  world.reset();
+  integrator = integratorId < (uint32_t)Integrator::Count ? (Integrator)integratorId : Integrator::SemiImplicitEuler;
+  if (substep > 0) world.fixedDt = substep;
+  bodies.reserve((size_t)count); // at most maxCount
+
+  const uint8_t* end = p + payload;
+  uint8_t rec[RecordSize] = {}, delta[RecordSize];
+  for (uint64_t i = 0; i < count; ++i){
+    if (flags & FlagCompressed){
+      size_t used = decompress(p, end - p, delta, RecordSize);
+      if (used == 0) return false;
+      p += used;
+      for (size_t k = 0; k < RecordSize; ++k) rec[k] ^= delta[k];
+      if (!unpackRecord(rec)) return false;
+    } else {
+      if (!unpackRecord(p)) return false;
+      p += RecordSize;
+    }
+  }
+  return true;
+}
+
+// Format picked from the file contents, so a binary snapshot can be opened wherever a CSV can
+SceneLoadReport LoadScene(const char* path){
+  if (!IsSceneBinary(path)) return LoadSceneCSV(path);
+  SceneLoadReport report;
+  report.opened = true;
+  if (!LoadSceneBinary(path)) report.fail(0, "malformed binary snapshot");
+  report.rows = bodies.size();
+  return report;
+}
+
+// Format picked from the extension: .phys => compressed binary, anything else => CSV
+void SaveScene(const char* path){
+  size_t n = std::strlen(path);
+  if (n >= 5 && std::strcmp(path + n - 5, ".phys") == 0) SaveSceneBinary(path, true);
+  else SaveSceneCSV(path);
+}
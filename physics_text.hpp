@@ -0,0 +1,173 @@
+#pragma once
+#include "raylib.h"
+#include "rlgl.h"
+#include "physics_variables.hpp"
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// ---------------- cached text ----------------
+// DrawTextEx decodes UTF-8 and searches the font's glyph list for every character of every string, every
+// frame. A TextLayout does that once per distinct string: it keeps the glyph quads relative to the text
+// origin and rebuilds them only when the string, size or font changes. draw() queues the quads into
+// textBatch, and flush() emits everything queued as textured quads under one texture bind, the same
+// vertices DrawTextEx would produce. CachedText binds a layout to the values it shows, so the string is
+// only formatted again when one of them changes.
+
+class TextBatch {
+  public:
+  static constexpr int chunkQuads = 512; // 2048 vertices, fits rlgl's smallest (GLES2) default batch
+
+  struct Quad {
+    Rectangle src, dst;
+    Color color;
+  };
+
+  void add(const Quad& q){ queued.push_back(q); }
+
+  // draws the queued quads with the font atlas, on top of everything drawn so far
+  void flush(const Font& font){
+    if (queued.empty()) return;
+    const float w = (float)font.texture.width, h = (float)font.texture.height;
+    for (size_t k = 0; k < queued.size(); k += chunkQuads){
+      const size_t end = std::min(queued.size(), k + (size_t)chunkQuads);
+      rlCheckRenderBatchLimit(4 * (int)(end - k));
+      rlSetTexture(font.texture.id);
+      rlBegin(RL_QUADS);
+      rlNormal3f(0.0f, 0.0f, 1.0f);
+      for (size_t i = k; i < end; ++i){
+        const Quad& q = queued[i];
+        const float u0 = q.src.x / w, v0 = q.src.y / h;
+        const float u1 = (q.src.x + q.src.width) / w, v1 = (q.src.y + q.src.height) / h;
+        rlColor4ub(q.color.r, q.color.g, q.color.b, q.color.a);
+        rlTexCoord2f(u0, v0); rlVertex2f(q.dst.x, q.dst.y);
+        rlTexCoord2f(u0, v1); rlVertex2f(q.dst.x, q.dst.y + q.dst.height);
+        rlTexCoord2f(u1, v1); rlVertex2f(q.dst.x + q.dst.width, q.dst.y + q.dst.height);
+        rlTexCoord2f(u1, v0); rlVertex2f(q.dst.x + q.dst.width, q.dst.y);
+      }
+      rlEnd();
+    }
+    rlSetTexture(0);
+    queued.clear();
+  }
+
+  private:
+  std::vector<Quad> queued;
+};
+
+TextBatch textBatch;
+
+// One string laid out in uiFont
+class TextLayout {
+  public:
+  static constexpr float lineSpacing = 2; // raylib's default SetTextLineSpacing()
+
+  // lays s out unless it is what is already laid out; true if it had to
+  bool set(std::string_view s, float size, float spacing = 1.0f){
+    if (font == uiFont.texture.id && size == fontSize && spacing == fontSpacing && s == text) return false;
+    text.assign(s.data(), s.size());
+    fontSize = size;
+    fontSpacing = spacing;
+    font = uiFont.texture.id;
+    layout();
+    return true;
+  }
+
+  const std::string& str() const { return text; }
+  Vector2 extent() const { return size; } // as MeasureTextEx
+
+  void draw(Vector2 pos, Color color) const {
+    for (const Glyph& g : glyphs)
+      textBatch.add({g.src, {pos.x + g.dst.x, pos.y + g.dst.y, g.dst.width, g.dst.height}, color});
+  }
+
+  private:
+  struct Glyph {
+    Rectangle src, dst; // atlas rectangle, and screen rectangle relative to the origin
+  };
+  std::string text;
+  float fontSize = 0, fontSpacing = 0;
+  unsigned int font = ~0u;
+  std::vector<Glyph> glyphs;
+  Vector2 size = {0, 0};
+
+  // same placement as DrawTextEx/DrawTextCodepoint
+  void layout(){
+    glyphs.clear();
+    const Font& f = uiFont;
+    if (f.baseSize == 0){ size = {0, 0}; return; } // font not loaded yet
+    const float scale = fontSize / f.baseSize;
+    const float pad = (float)f.glyphPadding;
+    float x = 0, y = 0, width = 0;
+    for (size_t i = 0; i < text.size();){
+      int bytes = 0;
+      const int cp = GetCodepointNext(text.c_str() + i, &bytes);
+      i += bytes > 0 ? bytes : 1;
+      if (cp == '\n'){
+        width = std::max(width, x - fontSpacing);
+        x = 0;
+        y += fontSize + lineSpacing;
+        continue;
+      }
+      const int g = GetGlyphIndex(f, cp);
+      const Rectangle& r = f.recs[g];
+      if (cp != ' ' && cp != '\t'){
+        glyphs.push_back({{r.x - pad, r.y - pad, r.width + 2 * pad, r.height + 2 * pad},
+                          {x + (f.glyphs[g].offsetX - pad) * scale, y + (f.glyphs[g].offsetY - pad) * scale,
+                           (r.width + 2 * pad) * scale, (r.height + 2 * pad) * scale}});
+      }
+      x += (f.glyphs[g].advanceX == 0 ? r.width : (float)f.glyphs[g].advanceX) * scale + fontSpacing;
+    }
+    width = std::max(width, x - fontSpacing);
+    size = {std::max(width, 0.0f), y + fontSize};
+  }
+};
+
+// A layout bound to the values it shows: update() formats the string through format(std::ostream&) only
+// when the values differ from the previous call.
+template<class... Key>
+class CachedText {
+  public:
+  explicit CachedText(float size, float spacing = 1.0f) : fontSize(size), fontSpacing(spacing) {}
+
+  template<class F>
+  const TextLayout& update(const Key&... key, F&& format){
+    std::tuple<Key...> k(key...);
+    if (!valid || k != last){
+      std::ostringstream oss;
+      format(oss);
+      last = k;
+      valid = true;
+      laid.set(oss.str(), fontSize, fontSpacing);
+    } else {
+      laid.set(laid.str(), fontSize, fontSpacing); // relays out only if the font changed
+    }
+    return laid;
+  }
+
+  private:
+  float fontSize, fontSpacing;
+  std::tuple<Key...> last;
+  bool valid = false;
+  TextLayout laid;
+};
+
+// Layouts of strings that keep their address (literals, L() texts), looked up by address and size
+class LabelCache {
+  public:
+  const TextLayout& get(const char* s, float size){
+    TextLayout& l = labels[{s, size}];
+    l.set(s, size);
+    return l;
+  }
+
+  private:
+  std::map<std::pair<const char*, float>, TextLayout> labels;
+};
+
+LabelCache labelCache;
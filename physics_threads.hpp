@@ -0,0 +1,129 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <utility>
+
+// Work-stealing pool for data-parallel phases. parallelFor() cuts [0,count) into chunks dealt round-robin
+// into per-worker deques; a worker pops from the back of its own deque and steals from the front of the others'.
+// The calling thread works as worker 0. Chunks only decide who computes an index, never what it computes,
+// so results don't depend on the thread count as long as fn writes disjoint outputs per index.
+// Emscripten builds have no pthreads and run everything on the calling thread.
+class ThreadPool {
+  public:
+  explicit ThreadPool(unsigned threads = 0){ resize(threads); }
+  ~ThreadPool(){ stop(); }
+
+  // 0 => one per hardware thread
+  void resize(unsigned threads){
+#ifdef __EMSCRIPTEN__
+    threads = 1;
+#endif
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads == size()) return;
+    stop();
+    queues = std::vector<Queue>(threads);
+    quit = false;
+    for (unsigned id = 1; id < threads; ++id) workers.emplace_back([this, id]{ workerLoop(id); });
+  }
+  unsigned size() const { return (unsigned)queues.size(); }
+
+  void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn){
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    if (size() <= 1 || count <= grain){
+      fn(0, count);
+      return;
+    }
+    size_t chunks = (count + grain - 1) / grain;
+    {
+      std::lock_guard<std::mutex> lock(m);
+      job = &fn;
+      remaining = chunks;
+      ++generation;
+    }
+    // published after job: a worker still draining the previous call may grab these right away
+    for (size_t c = 0; c < chunks; ++c){
+      Queue& q = queues[c % queues.size()];
+      std::lock_guard<std::mutex> lock(q.m);
+      q.items.push_back({c * grain, std::min(count, (c + 1) * grain)});
+    }
+    wake.notify_all();
+    runChunks(0);
+    std::unique_lock<std::mutex> lock(m);
+    done.wait(lock, [this]{ return remaining == 0; });
+    job = nullptr;
+  }
+
+  private:
+  struct Queue {
+    std::mutex m;
+    std::deque<std::pair<size_t, size_t>> items;
+  };
+  std::vector<Queue> queues;
+  std::vector<std::thread> workers;
+  std::mutex m;
+  std::condition_variable wake, done;
+  const std::function<void(size_t, size_t)>* job = nullptr;
+  size_t remaining = 0;        // chunks not yet finished, guarded by m
+  unsigned long long generation = 0;
+  bool quit = false;
+
+  bool take(unsigned id, std::pair<size_t, size_t>& out){
+    {
+      Queue& own = queues[id];
+      std::lock_guard<std::mutex> lock(own.m);
+      if (!own.items.empty()){
+        out = own.items.back();
+        own.items.pop_back();
+        return true;
+      }
+    }
+    for (size_t k = 1; k < queues.size(); ++k){
+      Queue& victim = queues[(id + k) % queues.size()];
+      std::lock_guard<std::mutex> lock(victim.m);
+      if (!victim.items.empty()){
+        out = victim.items.front();
+        victim.items.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void runChunks(unsigned id){
+    std::pair<size_t, size_t> r;
+    while (take(id, r)){
+      (*job)(r.first, r.second);
+      std::lock_guard<std::mutex> lock(m);
+      if (--remaining == 0) done.notify_all();
+    }
+  }
+
+  void workerLoop(unsigned id){
+    unsigned long long seen = 0;
+    for (;;){
+      {
+        std::unique_lock<std::mutex> lock(m);
+        wake.wait(lock, [&]{ return quit || generation != seen; });
+        if (quit) return;
+        seen = generation;
+      }
+      runChunks(id);
+    }
+  }
+
+  void stop(){
+    {
+      std::lock_guard<std::mutex> lock(m);
+      quit = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+    workers.clear();
+  }
+};
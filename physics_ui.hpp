@@ -5,8 +5,16 @@
 #include "raylib.h"
 #include "physics_variables.hpp"
 #include "physics_localisation.hpp"
+#include "physics_broadphase.hpp"
+#include "physics_recorder.hpp"
+#include "physics_scene.hpp"
+#include "physics_batch.hpp"
+#include "physics_sim.hpp"
+#include "physics_profiler.hpp"
+#include "physics_text.hpp"
 #include <list>
 
+
 class UI{
   public:
   Vector2 pos;
@@ -27,22 +35,23 @@ class UI{
 class WindowScaleUI : public UI{
   public:
   using UI::UI;
+  CachedText<double> text{24};
   void draw(){
-    std::ostringstream oss;
-    oss << L("ui.scale");
-    oss << std::fixed << std::setprecision(2) << 100/windowScale << "%";
-    
-    DrawTextEx(uiFont,oss.str().c_str(),vector(getX(),getY()),24,1.0f, WHITE);
+    text.update(windowScale,[](std::ostream& oss){
+      oss << L(Str::UiScale);
+      oss << std::fixed << std::setprecision(2) << 100/windowScale << "%";
+    }).draw(vector(getX(),getY()), WHITE);
   }
 };
 class TimeScaleUI : public UI{
   public:
   using UI::UI;
+  CachedText<float> text{24};
   void draw(){
-    std::ostringstream oss;
-    oss << L("ui.time");
-    oss << std::fixed << std::setprecision(3) << timeScale << "x";
-    DrawTextEx(uiFont,oss.str().c_str(),vector(getX(),getY()),24,1.0f, WHITE);
+    text.update(timeScale,[](std::ostream& oss){
+      oss << L(Str::UiTime);
+      oss << std::fixed << std::setprecision(3) << timeScale << "x";
+    }).draw(vector(getX(),getY()), WHITE);
   }
 };
 class PauseUI : public UI{
@@ -59,33 +68,157 @@ class OwnershipUI : public UI{
   public:
   using UI::UI;
   std::string text;
+  TextLayout layout;
   OwnershipUI(const std::string& name,int x=0,int y=0):UI(x,y){
-    this->text = L("ui.madeby")+name;
+    this->text = std::string(L(Str::UiMadeBy))+name;
   }
   void draw(){
-    DrawTextEx(uiFont,text.c_str(),vector(getX(),getY()),18,1.0f, WHITE);
+    layout.set(text,18);
+    layout.draw(vector(getX(),getY()), WHITE);
   }
 };
 class VisualScaleUI : public UI{
   public:
   using UI::UI;
-  std::string text;
-  VisualScaleUI(int x=0,int y=0):UI(x,y){
-    this->text = L("ui.visual_scaling");
-  }
+  CachedText<double> text{24};
   void draw(){
-    if(visualScaling) DrawTextEx(uiFont,(text+std::to_string(windowVisualScale)+"x").c_str(),vector(getX(),getY()),24,1.0f, WHITE);
+    if(!visualScaling) return;
+    text.update(windowVisualScale,[](std::ostream& oss){
+      oss << L(Str::UiVisualScaling) << std::to_string(windowVisualScale) << "x";
+    }).draw(vector(getX(),getY()), WHITE);
   }
 };
 class TrailLifetimeUI : public UI{
   public:
   using UI::UI;
-  std::string text;
-  TrailLifetimeUI(int x=0,int y=0):UI(x,y){
-    this->text = L("ui.trail_lifetime");
+  CachedText<double> text{24};
+  void draw(){
+    if(!editingTrailLifetime) return;
+    const double t = sim.view().trailLifetime;
+    text.update(t,[t](std::ostream& oss){
+      oss << L(Str::UiTrailLifetime) << std::to_string(t) << "s";
+    }).draw(vector(getX(),getY()), WHITE);
+  }
+};
+class GravitySolverUI : public UI{
+  public:
+  using UI::UI;
+  CachedText<GravitySolver,double,int> text{18};
+  void draw(){
+    const SimView& v = sim.view();
+    text.update(v.gravitySolver,v.barnesHutTheta,v.fmmOrder,[&v](std::ostream& oss){
+      if(v.gravitySolver==GravitySolver::BarnesHut) oss << L(Str::UiGravityBarnesHut) << std::fixed << std::setprecision(2) << v.barnesHutTheta;
+      else if(v.gravitySolver==GravitySolver::Fmm) oss << L(Str::UiGravityFmm) << v.fmmOrder;
+      else oss << L(Str::UiGravityExact);
+    }).draw(vector(getX(),getY()), WHITE);
+  }
+};
+class IntegratorUI : public UI{
+  public:
+  using UI::UI;
+  CachedText<Integrator> text{18};
+  void draw(){
+    const Integrator i = sim.view().scene.integrator;
+    text.update(i,[i](std::ostream& oss){
+      oss << L(Str::UiIntegrator) << integratorNames[(int)i];
+    }).draw(vector(getX(),getY()), WHITE);
+  }
+};
+class RecorderUI : public UI{
+  public:
+  using UI::UI;
+  CachedText<bool,uint64_t,uint64_t> replayText{18};
+  CachedText<uint64_t> recordingText{18};
+  void draw(){
+    const SimView& v = sim.view();
+    if(replay.active()){
+      replayText.update(true,replay.frame(),replay.frames(),[](std::ostream& oss){
+        oss << L(Str::UiReplay) << replay.frame()+1 << "/" << replay.frames() << " (" << std::fixed << std::setprecision(2) << replay.time() << "s)";
+      }).draw(vector(getX(),getY()), v.recording ? RED : WHITE);
+    } else if(v.recording){
+      recordingText.update(v.recordedFrames,[&v](std::ostream& oss){
+        oss << L(Str::UiRecording) << v.recordedFrames;
+      }).draw(vector(getX(),getY()), RED);
+    }
   }
+};
+class SaveStatusUI : public UI{
+  public:
+  using UI::UI;
+  CachedText<AsyncSceneSaver::Status,size_t> text{18};
+  void draw(){
+    const AsyncSceneSaver::Status status = sceneSaver.status();
+    if(status==AsyncSceneSaver::Status::Idle) return;
+    if(status!=AsyncSceneSaver::Status::Writing && sceneSaver.secondsSinceFinished() > 3) return;
+    const size_t percent = sceneSaver.total() ? sceneSaver.written()*100/sceneSaver.total() : 100;
+    text.update(status,percent,[status,percent](std::ostream& oss){
+      switch(status){
+        case AsyncSceneSaver::Status::Writing: oss << L(Str::UiSaving) << sceneSaver.path() << " " << percent << "%"; break;
+        case AsyncSceneSaver::Status::Done: oss << L(Str::UiSaved) << sceneSaver.path(); break;
+        default: oss << L(Str::UiSaveFailed) << sceneSaver.path(); break;
+      }
+    }).draw(vector(getX(),getY()), status==AsyncSceneSaver::Status::Failed ? RED : WHITE);
+  }
+};
+class BroadphaseUI : public UI{
+  public:
+  using UI::UI;
+  CachedText<size_t,size_t> text{18};
+  void draw(){
+    const SimView& v = sim.view();
+    text.update(v.candidatePairs,v.prunedPairs,[&v](std::ostream& oss){
+      oss << L(Str::UiPairs) << v.candidatePairs << L(Str::UiPairsPruned) << v.prunedPairs;
+    }).draw(vector(getX(),getY()), WHITE);
+  }
+};
+
+class CullingUI : public UI{
+  public:
+  using UI::UI;
+  CachedText<size_t,size_t,size_t> text{18};
+  void draw(){
+    text.update(shapeBatch.drawn(),shapeBatch.culled,shapeBatch.vertices,[](std::ostream& oss){
+      oss << L(Str::UiDrawn) << shapeBatch.drawn() << L(Str::UiCulled) << shapeBatch.culled << L(Str::UiVertices) << shapeBatch.vertices;
+    }).draw(vector(getX(),getY()), WHITE);
+  }
+};
+
+class SimRateUI : public UI{
+  public:
+  using UI::UI;
+  CachedText<double> text{18};
+  void draw(){
+    const double rate = sim.view().tickRate;
+    text.update(rate,[rate](std::ostream& oss){
+      oss << L(Str::UiSimRate) << std::fixed << std::setprecision(0) << rate << L(Str::UiHz);
+    }).draw(vector(getX(),getY()), WHITE);
+  }
+};
+
+// The table changes every frame, so it is re-formatted at a readable 4 Hz rather than per value
+class ProfilerUI : public UI{
+  public:
+  using UI::UI;
+  static constexpr double refreshRate = 4;
+  CachedText<long,bool> text{18};
   void draw(){
-    if(editingTrailLifetime) DrawTextEx(uiFont,(text+std::to_string(trailLifetime)+"s").c_str(),vector(getX(),getY()),24,1.0f, WHITE);
+    if(!showProfiler) return;
+    const bool capturing = Profiler::capturing.load();
+    text.update((long)(GetTime()*refreshRate),capturing,[capturing](std::ostream& oss){
+      const SimView& v = sim.view();
+      const Profiler::History& h = Profiler::history;
+      oss << std::fixed << std::setprecision(2);
+      oss << L(Str::UiProfiler) << (capturing ? L(Str::UiProfilerCapturing) : std::string_view()) << "\n";
+      for(int p=0;p<(int)Profiler::Phase::Count;p++){
+        Profiler::Phase phase = (Profiler::Phase)p;
+        if(h.averageCalls(phase)==0) continue;
+        oss << std::setw(11) << std::left << Profiler::phaseNames[p] << std::right
+            << std::setw(7) << h.averageMs(phase) << std::setw(7) << h.maxMs(phase)
+            << std::setw(7) << std::setprecision(0) << h.averageCalls(phase) << std::setprecision(2) << "\n";
+      }
+      oss << L(Str::UiProfilerBodies) << v.scene.rows.size() << L(Str::UiProfilerParticles) << v.particlePos.size() << "\n";
+      oss << L(Str::UiPairs) << v.candidatePairs;
+    }).draw(vector(getX(),getY()), WHITE);
   }
 };
 
@@ -8,12 +8,28 @@ int screenWidth = 1200;
 int screenHeight = 900;
 double freeFallAcceleration = 9.81;
 double gravitationalConstant = 6.67430e-11;
+const double gravitySoftening2 = 1e-4; // tune in engine units^2
+// gravity solver used by World::computeForces; exact is the O(N^2) sum, for checking the error of the others
+enum class GravitySolver { Exact, BarnesHut, Fmm, Count };
+const char* gravitySolverNames[] = {"exact", "barnes-hut", "fmm"};
+GravitySolver gravitySolver = GravitySolver::BarnesHut;
+double barnesHutTheta = 0.5; // opening angle: cell size / distance below which a cell is treated as one body
+int fmmOrder = 6;            // FMM expansion degree, 1..Fmm::MaxOrder
+double fmmTheta = 0.5;       // FMM: (radius a + radius b) / distance below which two cells use expansions
 auto windowPos = vector(0,0);
 double windowScale = 1;
 double windowVisualScale = 1;
 double trailLifetime = 20;
+unsigned physicsThreads = 0; // worker threads for the force phase, 0 = one per hardware thread
+double simulationRate = 1000; // simulation thread ticks per second (web builds tick once per frame)
+float renderAlpha = 1; // interpolation factor between the last two simulation substeps
+// time integration scheme used by World::substep, saved with the scene
+enum class Integrator { SemiImplicitEuler, Leapfrog, Yoshida4, Adaptive, Count };
+const char* integratorNames[] = {"euler", "leapfrog", "yoshida4", "adaptive"};
+Integrator integrator = Integrator::SemiImplicitEuler;
 bool visualScaling = false;
 bool editingTrailLifetime = false;
+bool showProfiler = false;
 double mouseWheelScaleFactor = 0.1;
 double visualScale(){
   if(visualScaling)return windowVisualScale;
@@ -0,0 +1,361 @@
+#pragma once
+#include "physics_engine.hpp"
+#include "physics_threads.hpp"
+#include "physics_profiler.hpp"
+#include "physics_simd.hpp"
+#include "physics_fmm.hpp"
+#include <vector>
+#include <cmath>
+#include <string>
+#include <cstring>
+
+Broadphase::Grid broadphase;
+ThreadPool threadPool(physicsThreads);
+
+bool ParseIntegrator(const std::string& name, Integrator& out){
+  for (int k = 0; k < (int)Integrator::Count; ++k){
+    if (name == integratorNames[k]){
+      out = (Integrator)k;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ParseGravitySolver(const std::string& name, GravitySolver& out){
+  for (int k = 0; k < (int)GravitySolver::Count; ++k){
+    if (name == gravitySolverNames[k]){
+      out = (GravitySolver)k;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Fixed-step world stepper. step() accumulates simulation time and runs whole substeps, each of which
+// runs every phase over all simulated bodies before the next one starts, so no body ever reads another
+// one half-advanced. How a substep splits into force evaluations, kicks (velocity) and drifts (position)
+// depends on the global integrator:
+//   euler     forces, collisions, kick h, drift h (semi-implicit, 1st order)
+//   leapfrog  drift h/2, forces, collisions, kick h, drift h/2 (symplectic, 2nd order, one force pass)
+//   yoshida4  three leapfrog stages of w1 h, w0 h, w1 h (symplectic, 4th order, three force passes)
+//   adaptive  leapfrog with h picked per substep from the bodies' accelerations, see adaptiveStep()
+class World {
+  public:
+  double fixedDt = 1.0 / 240.0; // ~4.17 ms substeps
+  int maxSubsteps = 2000;       // per step(); past this substeps get longer instead of more numerous
+  double adaptiveEta = 0.01;    // adaptive: fraction of the shortest body timescale taken per substep
+  double accumulator = 0;       // simulation time not yet stepped, same sign as the time scale
+  double lastDt = 1.0 / 240.0;  // length of the last substep
+  int lastSubsteps = 0;
+  // Per-world randomness: one stream for generators and colours, and emitter streams split from it.
+  // Random per window session; headless --seed and bench --seed set it for reproducible runs.
+  Rng::Stream random{((uint64_t)rd() << 32) | rd()};
+  uint64_t substeps = 0; // substeps since the world was seeded
+  // body ticks since the world was seeded, counted by SimThread::tick and HeadlessTick; a tick is
+  // often shorter than a substep, so this tells apart body-tick emitters that share one
+  uint64_t ticks = 0;
+
+  void seed(uint64_t s){
+    random.seed(s);
+    substeps = 0;
+    ticks = 0;
+  }
+
+  // defaults for a newly loaded scene, keeping the random state, so a world seeded before a load
+  // stays seeded
+  void reset(){
+    World fresh;
+    fresh.random = random;
+    fresh.substeps = substeps;
+    fresh.ticks = ticks;
+    *this = std::move(fresh);
+  }
+
+  // Stream for one emitter in the current substep and tick. It is a function of the seed, both
+  // counters and the ids alone, not of anything drawn before, so emitters give the same numbers in any
+  // order or on any thread. Ids must differ between emitters of one substep and tick.
+  Rng::Stream emitterStream(uint64_t emitter, uint64_t other) const {
+    return random.split(Rng::mix(Rng::mix(Rng::mix(emitter) ^ other) ^ substeps) ^ ticks);
+  }
+
+  void step(double dt){
+    if (integrator == Integrator::Adaptive){
+      stepAdaptive(dt);
+      return;
+    }
+    accumulator += dt;
+    int n = (int)(std::fabs(accumulator) / fixedDt);
+    double h = accumulator < 0 ? -fixedDt : fixedDt;
+    if (n > maxSubsteps){
+      n = maxSubsteps;
+      h = accumulator / n;
+    }
+    for (int i = 0; i < n; ++i) substep(h);
+    accumulator -= n * h;
+    if (n > 0) lastDt = h;
+    lastSubsteps = n;
+    renderAlpha = (float)std::clamp(accumulator / lastDt, 0.0, 1.0);
+  }
+
+  // variable substeps that always use up the whole accumulator
+  void stepAdaptive(double dt){
+    accumulator += dt;
+    computeForces(); // slots may have moved since the last step
+    int n = 0;
+    while (accumulator != 0 && n < maxSubsteps){
+      double h = adaptiveStep();
+      if (n == maxSubsteps - 1 || h >= std::fabs(accumulator)) h = std::fabs(accumulator);
+      if (accumulator < 0) h = -h;
+      substep(h);
+      accumulator -= h;
+      lastDt = h;
+      ++n;
+    }
+    accumulator = 0;
+    lastSubsteps = n;
+    renderAlpha = 0;
+  }
+
+  // eta times the shortest of |v|/|a| (time to turn the velocity) and sqrt(size/|a|) (time to fall
+  // one body size) over all simulated bodies, from the forces of the last evaluation
+  double adaptiveStep(){
+    double h = INFINITY;
+    for (size_t j = 0; j < force.size() && j < bodies.size(); ++j){
+      const BodyFlags& f = bodies.flags[j];
+      if (!f.simulated || f.shouldRemove || f.fixed || bodies.mass[j] <= 0) continue;
+      double a = distance(force[j]) / bodies.mass[j];
+      if (a <= 0) continue;
+      double size = std::max(bodies.radius[j], 0.5 * std::max(bodies.sides[j].x, bodies.sides[j].y));
+      double tau = std::max(distance(bodies.speed[j]) / a, std::sqrt(std::max(size, 1e-3) / a));
+      h = std::min(h, adaptiveEta * tau);
+    }
+    return std::max(h, fixedDt / 64);
+  }
+
+  void substep(double h){
+    ++substeps;
+    bodies.prevPos = bodies.pos;
+    switch (integrator){
+      case Integrator::SemiImplicitEuler:
+        computeForces();
+        resolveCollisions();
+        kick(h);
+        drift(h);
+        break;
+      case Integrator::Leapfrog:
+      case Integrator::Adaptive:
+        drift(h * 0.5);
+        computeForces();
+        resolveCollisions();
+        kick(h);
+        drift(h * 0.5);
+        break;
+      case Integrator::Yoshida4: {
+        const double cbrt2 = std::cbrt(2.0);
+        const double w1 = 1.0 / (2.0 - cbrt2), w0 = -cbrt2 / (2.0 - cbrt2);
+        const double c[4] = {w1 * 0.5, (w0 + w1) * 0.5, (w0 + w1) * 0.5, w1 * 0.5};
+        const double d[3] = {w1, w0, w1};
+        for (int k = 0; k < 3; ++k){
+          drift(c[k] * h);
+          computeForces();
+          if (k == 2) resolveCollisions();
+          kick(d[k] * h);
+        }
+        drift(c[3] * h);
+        break;
+      }
+      default: break;
+    }
+    sanitize();
+  }
+
+  // the phases are public so they can be timed on their own (physics_bench.cpp)
+  void computeForces(){
+    Profiler::Scope zone(Profiler::Phase::Gravity);
+    const size_t n = bodies.size();
+    force.assign(n, vector(0, 0));
+    if (gravitySolver == GravitySolver::Fmm){
+      fmmSolver.clear();
+      for (size_t j = 0; j < n; ++j){
+        if (bodies.mass[j] == 0 || bodies.flags[j].shouldRemove) continue;
+        fmmSolver.add(bodies.pos[j].x, bodies.pos[j].y, bodies.mass[j], (int)j);
+      }
+      fmmSolver.solve(fmmOrder, fmmTheta, threadPool);
+      for (size_t k = 0; k < fmmSolver.size(); ++k){
+        const int j = fmmSolver.id(k);
+        if (!bodies.flags[j].simulated) continue;
+        force[j] = vector(fmmSolver.fieldX(k), fmmSolver.fieldY(k)) * (gravitationalConstant * bodies.mass[j]);
+      }
+      return;
+    }
+    const bool useBarnesHut = gravitySolver == GravitySolver::BarnesHut;
+    if (useBarnesHut){
+      gravityTree.clear();
+      for (size_t j = 0; j < n; ++j){
+        if (bodies.mass[j] == 0 || bodies.flags[j].shouldRemove) continue;
+        gravityTree.add(bodies.pos[j].x, bodies.pos[j].y, bodies.mass[j], (int)j);
+      }
+      gravityTree.build();
+    }
+    // the direct sum goes through the vectorised kernels; the scalar double kernel keeps exactField() as
+    // the reference. Barnes-Hut stays scalar, its walk costs more than the sums it feeds.
+    const Simd::Isa isa = gravityIsa;
+    const Simd::Precision precision = gravityPrecision;
+    const bool vectorised = !useBarnesHut && (isa != Simd::Isa::Scalar || precision != Simd::Precision::Double);
+    if (vectorised){
+      // a body's own entry adds exactly 0 (dx = dy = 0), so one packed list serves every body
+      exactSources.clear();
+      for (size_t j = 0; j < n; ++j){
+        if (bodies.mass[j] == 0 || bodies.flags[j].shouldRemove) continue;
+        exactSources.add(bodies.pos[j].x, bodies.pos[j].y, bodies.mass[j]);
+      }
+      exactSources.finish(precision);
+    }
+    // positions are read-only for the rest of the phase and every body writes only force[j]
+    threadPool.parallelFor(n, 256, [&](size_t begin, size_t end){
+      for (size_t j = begin; j < end; ++j){
+        if (!bodies.flags[j].simulated || bodies.flags[j].shouldRemove || bodies.mass[j] == 0) continue;
+        double fx, fy;
+        if (useBarnesHut) gravityTree.field(bodies.pos[j].x, bodies.pos[j].y, (int)j, fx, fy);
+        else if (vectorised) Simd::field(isa, precision, exactSources, bodies.pos[j].x, bodies.pos[j].y, fx, fy);
+        else exactField(j, fx, fy);
+        force[j] = vector(fx, fy) * (gravitationalConstant * bodies.mass[j]);
+      }
+    });
+  }
+
+  // per-slot forces from the last computeForces()
+  const std::vector<Vector2>& forces() const { return force; }
+
+  static void exactField(size_t self, double& fx, double& fy){
+    const double px = bodies.pos[self].x, py = bodies.pos[self].y;
+    fx = 0; fy = 0;
+    for (size_t j = 0; j < bodies.size(); ++j){
+      if (bodies.mass[j] == 0 || bodies.flags[j].shouldRemove || j == self) continue;
+      double dx = bodies.pos[j].x - px;
+      double dy = bodies.pos[j].y - py;
+      double r2 = dx*dx + dy*dy + gravitySoftening2;
+      double invR = 1.0 / std::sqrt(r2);
+      double scalarF = bodies.mass[j] / r2;
+      fx += dx * invR * scalarF;
+      fy += dy * invR * scalarF;
+    }
+  }
+
+  void resolveCollisions(){
+    Profiler::Scope zone(Profiler::Phase::Collisions);
+    broadphase.clear();
+    broadphaseSlots.clear();
+    for (size_t j = 0; j < bodies.size(); ++j){
+      if (!bodies.flags[j].simulated || bodies.flags[j].shouldRemove) continue;
+      Object* o = bodies.handle[j];
+      if (o->lastCollision && !o->checkCollision(o->lastCollision)) o->lastCollision = nullptr;
+      // circles have sides {0,0} and rectangles radius 0, so one formula covers both
+      double hx = std::max(bodies.radius[j], bodies.sides[j].x * 0.5);
+      double hy = std::max(bodies.radius[j], bodies.sides[j].y * 0.5);
+      const Vector2& p = bodies.pos[j];
+      broadphase.add({p.x - hx, p.y - hy, p.x + hx, p.y + hy});
+      broadphaseSlots.push_back((int)j);
+    }
+    broadphase.build();
+
+    // each candidate pair once; the narrowphase updates both bodies
+    for (int i = 0; i < (int)broadphaseSlots.size(); ++i){
+      for (const int* k = broadphase.begin(i); k != broadphase.end(i); ++k){
+        if (*k < i) continue;
+        int a = broadphaseSlots[i], b = broadphaseSlots[*k];
+        if (bodies.flags[a].shouldRemove || bodies.flags[b].shouldRemove) continue;
+        if (bodies.mass[b] == 0) std::swap(a, b);
+        if (bodies.mass[b] == 0) continue;
+        bodies.handle[a]->resolveCollision(bodies.handle[b]);
+      }
+    }
+  }
+
+  // velocities from the last computeForces(), friction and constant gravity over h
+  void kick(double h){
+    Profiler::Scope zone(Profiler::Phase::Integrate);
+    // bodies spawned during this substep are past the end of force
+    for (size_t j = 0; j < force.size(); ++j){
+      const BodyFlags& f = bodies.flags[j];
+      if (!f.simulated || f.shouldRemove || f.fixed) continue;
+      Vector2& speed = bodies.speed[j];
+      // friction as exponential decay for stability
+      speed *= (float)std::exp(-bodies.frictionFactor[j] * h);
+      if (f.gravityAffected) speed.y += (float)(freeFallAcceleration * h);
+      if (bodies.mass[j] > 0.0){
+        Vector2 a = force[j] / bodies.mass[j];
+        speed += a * (float)h;
+      }
+    }
+  }
+
+  // positions from the current velocities
+  void drift(double h){
+    Profiler::Scope zone(Profiler::Phase::Integrate);
+    for (size_t j = 0; j < bodies.size(); ++j){
+      const BodyFlags& f = bodies.flags[j];
+      if (!f.simulated || f.shouldRemove || f.fixed) continue;
+      bodies.pos[j] += bodies.speed[j] * (float)h;
+    }
+  }
+
+  void sanitize(){
+    for (size_t j = 0; j < bodies.size(); ++j){
+      const BodyFlags& f = bodies.flags[j];
+      if (!f.simulated || f.shouldRemove) continue;
+      Vector2& speed = bodies.speed[j];
+      Vector2& pos = bodies.pos[j];
+      if (!std::isfinite(speed.x)) speed.x = 0;
+      if (!std::isfinite(speed.y)) speed.y = 0;
+      if (!std::isfinite(pos.x))   pos.x   = 0;
+      if (!std::isfinite(pos.y))   pos.y   = 0;
+      const double VMAX = 1e7;
+      double vlen = distance(speed);
+      if (vlen > VMAX) speed *= (float)(VMAX / vlen);
+    }
+  }
+
+  private:
+  Gravity::Tree gravityTree;
+  Simd::Sources exactSources;
+  Fmm::Solver fmmSolver;
+  std::vector<Vector2> force;
+  std::vector<int> broadphaseSlots; // grid index -> body slot
+};
+
+World world;
+
+Rng::Stream& worldRandom(){ return world.random; }
+Rng::Stream emitterStream(uint64_t emitter, uint64_t other){ return world.emitterStream(emitter, other); }
+
+// Bit-exact hash of the evolving state: every body's id, position, speed, mass, size and flags, then
+// every particle. Equal hashes step by step mean two runs are identical; runs are only comparable with
+// the same solver, kernel and precision, since those round differently.
+uint64_t StateHash(){
+  uint64_t h = Rng::Stream::gamma ^ bodies.size();
+  auto add = [&h](uint64_t w){ h = Rng::mix(h ^ w) + Rng::Stream::gamma; };
+  auto bits = [](auto v){
+    uint64_t w = 0;
+    static_assert(sizeof(v) <= sizeof(w), "one word per value");
+    std::memcpy(&w, &v, sizeof(v));
+    return w;
+  };
+  for (size_t j = 0; j < bodies.size(); ++j){
+    const BodyFlags& f = bodies.flags[j];
+    add(bodies.handle[j]->uuid);
+    add(bits(bodies.pos[j]));
+    add(bits(bodies.speed[j]));
+    add(bits(bodies.mass[j]));
+    add(bits(bodies.radius[j]));
+    add(bits(bodies.sides[j]));
+    add(f.gravityAffected | f.fixed << 1 | f.leaveTrail << 2 | f.shouldRemove << 3 | f.simulated << 4);
+  }
+  add(particles.size());
+  for (size_t k = 0; k < particles.size(); ++k){
+    add(bits(particles.pos[k]));
+    add(bits(particles.speed[k]));
+  }
+  return h;
+}